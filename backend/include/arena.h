@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator for per-connection request/response lifecycles.
+// Allocations are O(1) pointer bumps out of chained blocks; nothing is
+// freed individually — arena_reset() recycles everything at once at
+// end-of-request, keeping the first block hot for the next request.
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    char data[];
+} ArenaBlock;
+
+typedef struct Arena {
+    ArenaBlock* head;
+    size_t block_size;
+} Arena;
+
+void arena_init(Arena* arena, size_t block_size);
+void* arena_alloc(Arena* arena, size_t size);
+char* arena_strdup(Arena* arena, const char* s);
+char* arena_strndup(Arena* arena, const char* s, size_t n);
+void arena_reset(Arena* arena);
+void arena_destroy(Arena* arena);
+
+#endif // ARENA_H
@@ -36,6 +36,16 @@ typedef struct {
     bool hsts_enabled;
 } SecurityPolicy;
 
+// A captured path parameter. Both fields are borrowed views: name points
+// into the route trie (NUL-terminated, without the leading ':'), value
+// points into the request's path buffer and is NOT NUL-terminated —
+// value_len delimits it. No copies are made during matching.
+typedef struct {
+    const char* name;
+    const char* value;
+    size_t value_len;
+} PathParam;
+
 typedef struct Request {
     const char* method;
     const char* path;
@@ -49,13 +59,13 @@ typedef struct Request {
         const char** header_values;
         size_t header_count;
 
-        const char** param_names;
-        const char** param_values;
+        const PathParam* params;
         size_t param_count;
-        
+
         void* metrics;
         char* trace_id;
         void* plugin_data;
+        void* arena;  // owning per-connection Arena, or NULL
         CompressionType compression;
     } _internal;
 } Request;
@@ -72,7 +82,10 @@ typedef struct Response {
         size_t header_count;
         uv_stream_t* client;
         void* metrics;
+        void* arena;  // owning per-connection Arena, or NULL
         bool headers_sent;
+        bool async;       // handler completes via res_complete()
+        bool async_done;  // res_complete() has run
         CompressionType compression;
     } _internal;
 } Response;
@@ -93,6 +106,13 @@ typedef void (*PluginInit)(void);
 typedef void (*PluginRequestHook)(Request* req, Response* res);
 typedef void (*Middleware)(Request* req, Response* res, void (*next)(Request*, Response*));
 
+// Streaming request bodies. on_chunk is invoked as body bytes arrive;
+// returning false pauses the socket until req_stream_resume(). on_done
+// fires after the final byte; send the response from it.
+typedef bool (*BodyChunkHandler)(const Request* req, Response* res,
+                                 const char* chunk, size_t len, void* user);
+typedef void (*BodyDoneHandler)(const Request* req, Response* res, void* user);
+
 typedef struct {
     LogLevel min_level;
     bool enable_tracing;
@@ -107,14 +127,23 @@ typedef struct {
     uint64_t bytes_sent;
 } RequestMetrics;
 
+// One route's aggregated counters and latency quantiles, as returned by
+// reavix_metrics_snapshot(). `route` points into the sealed router and
+// stays valid until the next re-seal.
 typedef struct {
-    char* name;
-    char* value;
-} PathParam;
+    const char* route;
+    uint64_t requests;
+    uint64_t bytes_sent;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t p999_us;
+} ReavixRouteMetrics;
+
 
 typedef struct TrieNode {
     char* segment;
     RouteHandler handler;
+    uint8_t handler_mode;  // sync / async / thread-pool, set at registration
     struct TrieNode* children;
     struct TrieNode* param_child;
     size_t child_count;
@@ -131,8 +160,71 @@ typedef struct {
 // Core API
 bool reavix_init(size_t max_routes);
 bool reavix_route(const char* method, const char* path, RouteHandler handler);
+
+// Async variant: the handler may return without finishing the response
+// and call res_complete() later from a loop-thread callback. The
+// Response, Request, and their arena stay alive (and the connection
+// stops reading) until completion.
+bool reavix_route_async(const char* method, const char* path, RouteHandler handler);
+
+// Thread-pool variant for CPU-heavy handlers: the handler runs on the
+// libuv work queue and the response is completed automatically when it
+// returns. The handler must only touch req/res, never loop handles.
+bool reavix_route_work(const char* method, const char* path, RouteHandler handler);
+
+// Streaming-body variant: the handler runs as soon as the request's
+// headers are complete — before any body bytes — and must register
+// chunk callbacks with req_stream_body(). The body is never buffered
+// and is exempt from the buffered-body size cap, so multi-hundred-MB
+// uploads process from the first byte at bounded memory.
+bool reavix_route_stream(const char* method, const char* path, RouteHandler handler);
+
+// Register the body callbacks from inside a streaming route's handler.
+// req->body stays NULL; req->body_length carries the Content-Length.
+// If the handler returns without calling this, the connection is closed
+// after the response since the body cannot be replayed.
+void req_stream_body(const Request* req, Response* res,
+                     BodyChunkHandler on_chunk, BodyDoneHandler on_done, void* user);
+
+// Resume a body stream paused by on_chunk returning false. Must be
+// called on the connection's loop thread.
+void req_stream_resume(Response* res);
+
+// Bytes a paused stream may leave buffered before the connection is
+// dropped as unresponsive (default 1MB)
+void reavix_set_stream_watermark(size_t max_buffered_bytes);
+
+// Finish a response started by an async route: sends it if the handler
+// has not already, then recycles the request state and resumes the
+// connection. Must be called on the connection's loop thread.
+void res_complete(Response* res);
+
+// Compile the registered routes into a flat, cache-friendly dispatch
+// table: nodes in one contiguous block, segments interned in a shared
+// string table, children sorted for binary search. Call once after all
+// routes are registered; matching transparently prefers the sealed
+// table. Routes registered afterwards trigger an automatic re-seal.
+bool reavix_router_seal(void);
+
+// Route-table snapshots. Save writes the sealed dispatch table to a
+// binary file (seal first); load mmaps it back and publishes it, so
+// boot skips trie construction and sealing entirely — call it before
+// registering routes, then register as usual and handlers bind into
+// the mapped table by route pattern (until bound, a route answers
+// 404). The mapping is private and read-mostly, so clean pages stay
+// shared between instances mapping the same file. Snapshots are
+// build-specific; a file from a different build is rejected and load
+// returns false, after which normal registration and sealing apply.
+bool reavix_router_snapshot_save(const char* file);
+bool reavix_router_snapshot_load(const char* file);
+
 void reavix_server(uint16_t port);
 
+// Multi-threaded server: n_workers event loops, each with its own
+// SO_REUSEPORT listener and client table. reavix_server(port) is
+// equivalent to reavix_server_threaded(port, 1). Blocks until shutdown.
+void reavix_server_threaded(uint16_t port, size_t n_workers);
+
 // Response helpers
 void res_send_json(Response* res, const char* json);
 void res_send_file(Response* res, const char* filepath);
@@ -141,9 +233,43 @@ void res_send_error(Response* res, int code, const char* message);
 bool res_write(Response* res, const char* data, size_t len);
 void res_compress(Response* res, CompressionType type);
 
-// Request helpers
+// Bodies smaller than min_bytes are sent uncompressed even when a
+// compression type is set (default 256)
+void reavix_set_compression_threshold(size_t min_bytes);
+
+// Connection deadlines, in milliseconds: time allowed to finish reading
+// a request's headers, to finish reading its body, and to sit idle
+// between keep-alive requests. Pass 0 to leave a value unchanged.
+// Defaults: 10s / 30s / 60s. Enforced by a per-worker timer wheel.
+void reavix_set_timeouts(uint64_t header_read_ms, uint64_t body_read_ms, uint64_t idle_ms);
+
+// Listener tuning, applied when the server starts: the listen(2) backlog
+// (default SOMAXCONN) and TCP_DEFER_ACCEPT in seconds (0 disables it, the
+// default) so accept wakeups wait for the client's first data. Pass a
+// non-positive backlog or negative defer value to leave it unchanged.
+void reavix_set_listen_options(int backlog, int defer_accept_secs);
+
+// IPC transport: same-host callers reach the router over a Unix domain
+// socket with length-prefixed binary framing, skipping HTTP parsing.
+// Set the socket path before the server starts and enable it with
+// reavix_enable_protocol(PROTOCOL_IPC). Frames (integers little-endian,
+// payload_len excluding its own four bytes):
+//
+//   request:  [u32 payload_len][u8 method_len][method]
+//             [u16 path_len][path][body...]
+//   response: [u32 payload_len][u16 status][body...]
+//
+// Requests dispatch through the normal middleware and router machinery
+// to sync handlers (deferred-completion routes answer 501). A peer may
+// also pass an established TCP socket over the pipe; it is adopted as
+// a regular HTTP client.
+void reavix_set_ipc_path(const char* path);
+
+// Request helpers. req_get_param returns a length-delimited view into
+// the request path (see PathParam); use req_get_param_len for its size.
 const char* req_get_header(const Request* req, const char* key);
 const char* req_get_param(const Request* req, const char* key);
+size_t req_get_param_len(const Request* req, const char* key);
 const char* req_get_body(const Request* req);
 size_t req_get_body_length(const Request* req);
 
@@ -151,6 +277,20 @@ size_t req_get_body_length(const Request* req);
 bool res_has_header(const Response* res, const char* key);
 void res_remove_header(Response* res, const char* key);
 
+// Metrics. Hot-path recording is a few unsynchronized per-worker
+// increments; aggregation across workers happens here, at scrape time.
+// Fills out with up to max_routes sealed routes that have a handler and
+// returns the number filled. The same data backs the built-in /metrics
+// text endpoint (served when no user route claims that path).
+size_t reavix_metrics_snapshot(ReavixRouteMetrics* out, size_t max_routes);
+
+// Memory management
+void request_free(Request* req);
+void response_free(Response* res);
+
+// Logging
+void reavix_log(LogLevel level, const char* trace_id, const char* fmt, ...);
+
 // Configuration
 void reavix_set_error_handler(ErrorHandler handler);
 void reavix_log_configure(LogConfig config);
@@ -161,11 +301,36 @@ void reavix_set_rate_limits(const char* path, RateLimitConfig config);
 void reavix_register_plugin(Plugin plugin);
 void reavix_enable_protocol(uint8_t protocol);
 
-// Middleware
+// Middleware. Runs in registration order, before plugin pre-handlers
+// and the route handler; call next(req, res) to continue the chain.
+// Returning without calling next(), or sending the response,
+// short-circuits everything after it. The chain is compiled into a
+// flat call table at registration, so dispatch costs one indirect
+// call per step and never allocates.
 void reavix_use(Middleware middleware);
 
-// WebSocket support
+// WebSocket support. permessage-deflate (RFC 7692) is negotiated
+// automatically at upgrade when the client offers it; outgoing messages
+// at or above the compression threshold are then deflated, and
+// broadcast/publish compress a message once for every accepting
+// recipient. reavix_ws_send must run on the connection's loop thread
+// (i.e. from a handler or loop callback); broadcast and publish are
+// safe from any thread — they encode the frame once and hand delivery
+// to each connection's own event loop.
 void reavix_ws_send(Response* res, const char* message);
 void reavix_ws_broadcast(const char* message);
 
+// Topic pub/sub. When an upgrade succeeds, the matched route's sync
+// handler runs with the Response bound to the upgraded connection (the
+// HTTP send helpers become no-ops at that point) — subscribe from
+// there. Subscribe an upgraded connection (identified by its
+// Response, as in reavix_ws_send) to a '/'-separated topic pattern;
+// "*" matches exactly one segment, a trailing "#" matches any
+// remainder. Publishing encodes the frame once and fans it out to the
+// matching subscribers only, under the same backpressure policy as
+// broadcast. Subscriptions end at unsubscribe or disconnect.
+bool reavix_ws_subscribe(Response* res, const char* topic);
+void reavix_ws_unsubscribe(Response* res, const char* topic);
+void reavix_ws_publish(const char* topic, const char* message);
+
 #endif // LIBREAVIX_H
\ No newline at end of file
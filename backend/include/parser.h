@@ -0,0 +1,44 @@
+#ifndef PARSER_H
+#define PARSER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// Vectorized HTTP request parser. One pass finds CRLF boundaries with
+// SIMD (AVX2/SSE2 on x86-64, NEON on aarch64, scalar elsewhere — the
+// implementation is picked once at startup) and tokenizes the request
+// line and headers into (pointer, length) views over the input buffer.
+// Nothing is copied and nothing is NUL-terminated.
+
+#define PARSER_MAX_HEADERS 32
+
+typedef struct {
+    const char* name;
+    size_t name_len;
+    const char* value;
+    size_t value_len;
+} HeaderView;
+
+typedef struct {
+    const char* method;
+    size_t method_len;
+    const char* target;  // path plus optional ?query
+    size_t target_len;
+    int minor_version;   // 0 or 1; -1 if the version was unrecognized
+    HeaderView headers[PARSER_MAX_HEADERS];
+    size_t header_count;
+} ParsedRequest;
+
+// Select the SIMD implementation for this CPU; safe to call more than
+// once. Parsing functions self-initialize if this was skipped.
+void parser_init(void);
+
+// Offset one past the blank line terminating the header block, or 0 if
+// the block is still incomplete.
+size_t parser_find_headers_end(const char* data, size_t len);
+
+// Parse the request line and headers. Returns the number of bytes
+// consumed (the full header block), 0 if incomplete, -1 if malformed.
+ssize_t parser_parse_request(const char* data, size_t len, ParsedRequest* out);
+
+#endif // PARSER_H
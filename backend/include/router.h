@@ -0,0 +1,89 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include "libreavix.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define MAX_PARAMS 10
+
+// Compact method enum indexing each node's handler table. Methods
+// outside this set are rejected at registration and match time.
+typedef enum {
+    ROUTE_METHOD_GET = 0,
+    ROUTE_METHOD_POST,
+    ROUTE_METHOD_PUT,
+    ROUTE_METHOD_DELETE,
+    ROUTE_METHOD_PATCH,
+    ROUTE_METHOD_HEAD,
+    ROUTE_METHOD_OPTIONS,
+    ROUTE_METHOD_COUNT
+} RouteMethod;
+
+typedef struct {
+    char* method;
+    char* path;
+    RouteHandler handler;
+} RouteEntry;
+
+// One route for router_add_batch(); views are borrowed for the call
+typedef struct {
+    const char* method;
+    const char* path;
+    RouteHandler handler;
+} RouteSpec;
+
+// Radix trie node. `segment` is a label of one or more '/'-joined path
+// segments: published snapshots fold chains of pass-through nodes into
+// their child, so a long static prefix costs one comparison instead of
+// one traversal per segment. Handlers are per-method, so two methods on
+// the same path dispatch independently.
+typedef struct RouterNode {
+    char* segment;
+    RouteHandler handlers[ROUTE_METHOD_COUNT];
+    struct RouterNode* children;
+    struct RouterNode* param_child;
+    size_t child_count;
+    size_t child_capacity;  // children grow geometrically in the slab
+    RateLimitConfig rate_limit;
+} RouterNode;
+
+// Bump-pointer block chain backing every router allocation (defined in
+// router.c); freed wholesale in router_free()
+typedef struct RouterSlabBlock RouterSlabBlock;
+
+// Standalone router module. Writers (router_add, router_add_batch)
+// build the trie under the mutex and publish an immutable, radix-
+// compressed snapshot through live_root; readers (router_match) load
+// the snapshot with acquire ordering and walk it with no locking. All
+// nodes, strings and snapshots live in the slab, so superseded
+// snapshots are simply left in place until router_free() — routes are
+// immutable after startup, so the waste is bounded by the registration
+// phase. dup_table is an open-addressed hash set of route-table
+// indices (offset by one) for O(1) duplicate checks.
+typedef struct {
+    RouterNode* root;                 // build tree, guarded by mutex
+    _Atomic(RouterNode*) live_root;   // published read-only snapshot
+    RouterSlabBlock* slab;            // owns every node/string/array
+    RouteEntry* routes;
+    size_t route_count;
+    size_t route_capacity;
+    uint32_t* dup_table;
+    size_t dup_capacity;              // power of two
+    pthread_mutex_t mutex;
+} Router;
+
+bool router_init(size_t initial_capacity);
+void router_free(void);
+bool router_add(const char* method, const char* path, RouteHandler handler);
+
+// Bulk registration: inserts every valid, non-duplicate entry and
+// publishes a single snapshot at the end, so loading n routes is O(n)
+// instead of one full-tree clone per route. Returns the number of
+// routes actually inserted; duplicates and unknown methods are skipped.
+size_t router_add_batch(const RouteSpec* entries, size_t n);
+bool router_match(const char* method, const char* path,
+                  PathParam* params, size_t* param_count,
+                  RouteHandler* handler);
+
+#endif // ROUTER_H
@@ -1,16 +1,64 @@
 #include "libreavix.h"
+#include "arena.h"
+#include "parser.h"
 #include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
+#include <strings.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <zlib.h>
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <time.h>
 #include <errno.h>
 
 #define MAX_PARAMS 10
 #define MAX_PLUGINS 20
 #define MAX_MIDDLEWARE 10
+#define MAX_WORKERS 64
 #define WS_FRAME_SIZE 4096
+#define READ_BUFFER_SIZE 16384
+#define MAX_HEADER_SIZE 32768
+#define MAX_BODY_SIZE (16 * 1024 * 1024)
+// Responses whose headers+body fit in one pooled buffer are coalesced
+// into a single contiguous write
+#define WRITE_INLINE_SIZE 4096
+// Bodies below this (configurable) size are not worth compressing
+#define COMPRESSION_MIN_SIZE 256
+// Bodies at or above this size are compressed and transmitted in
+// chunked pipeline instead of being buffered fully
+#define COMPRESS_STREAM_THRESHOLD 65536
+#define COMPRESS_CHUNK_SIZE 16384
+// Connection-deadline timer wheel: one coarse uv_timer per worker loop
+// ticking every TIMER_WHEEL_TICK_MS, slots hashed by deadline
+#define TIMER_WHEEL_SLOTS 256  // power of two
+#define TIMER_WHEEL_TICK_MS 250
+
+#ifdef REAVIX_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+// How a route's handler runs: on the loop thread to completion, on the
+// loop thread with deferred completion via res_complete(), or on the
+// libuv thread pool with automatic completion.
+enum {
+    ROUTE_MODE_SYNC = 0,
+    ROUTE_MODE_ASYNC = 1,
+    ROUTE_MODE_WORK = 2,
+    ROUTE_MODE_STREAM = 3
+};
+
+// How much a paused body stream may leave buffered before the
+// connection is dropped (configurable)
+#define STREAM_WATERMARK_DEFAULT (1 << 20)
 
 // Internal structures
 typedef struct {
@@ -19,17 +67,247 @@ typedef struct {
     RouteHandler handler;
 } RouteEntry;
 
-typedef struct {
+struct ReavixWorker;
+struct FileSend;
+struct BodyStream;
+struct WsSubscription;
+
+typedef struct ClientContext {
     uv_stream_t* stream;
+    struct ReavixWorker* worker;
+    uint32_t ip;  // peer IPv4 address, 0 if unavailable
+    // Per-connection bump allocator backing all Request/Response
+    // internals; reset in one shot after each request
+    Arena arena;
+    // HTTP/1.1 connection state: bytes not yet forming a complete
+    // request accumulate here across reads; complete (possibly
+    // pipelined) requests are drained from it in sequence
+    char* inbuf;
+    size_t inbuf_len;
+    size_t inbuf_cap;
+    bool keep_alive;
     bool is_websocket;
     bool websocket_connected;
+    // permessage-deflate negotiated at upgrade (RFC 7692); outgoing
+    // frames above the compression threshold are deflated
+    bool ws_deflate;
+    // Request currently being dispatched; lets response helpers consult
+    // request headers (e.g. Range) without widening their signatures
+    const Request* current_req;
+    // In-flight sendfile stream, if any. Reads are paused and close is
+    // deferred until the file has fully left the socket.
+    struct FileSend* file_send;
+    bool close_after_send;
+    // An async handler owns the current request; the arena is not reset
+    // and reads stay paused until res_complete()
+    bool async_pending;
+    // Active streaming-body transfer, if any: incoming bytes bypass HTTP
+    // framing and go straight to the handler's chunk callback
+    struct BodyStream* body_stream;
+    // Intrusive membership in the worker's WebSocket client list, plus
+    // the bytes of queued frames used for the backpressure watermarks
+    struct ClientContext* ws_prev;
+    struct ClientContext* ws_next;
+    size_t ws_queued_bytes;
+    // This connection's topic subscriptions, for teardown on close
+    struct WsSubscription* ws_subs;
+    // Timer-wheel membership for the header/body/idle deadlines
+    struct ClientContext* wheel_prev;
+    struct ClientContext* wheel_next;
+    uint64_t deadline_ms;
+    int wheel_slot;  // -1 when unscheduled
 } ClientContext;
 
+// Open-addressing registry of a worker's live connections, keyed by
+// stream pointer. Context retrieval itself is O(1) via uv_handle_t.data;
+// the table exists for iteration (broadcast) and membership checks.
+typedef struct {
+    ClientContext** slots;
+    size_t capacity;  // power of two, 0 until first insert
+    size_t count;
+} ClientTable;
+
+// Sentinel for deleted slots so probe chains stay intact
+#define CLIENT_SLOT_TOMBSTONE ((ClientContext*)-1)
+
+// A connection's handle and context in one allocation, recycled through
+// a per-worker freelist so an accept burst does no allocator work. The
+// handle is the first member, so handle and slot pointers coincide and
+// the close callback can recover the slot from the uv_handle_t alone.
+#define CLIENT_POOL_MAX 256
+// Initial client-table capacity reserved at bind time so a reconnect
+// stampede never rehashes the table mid-accept
+#define CLIENT_TABLE_INITIAL 4096
+
+typedef struct ClientSlot {
+    uv_tcp_t handle;
+    ClientContext ctx;
+    struct ClientSlot* next;  // freelist link, unused while live
+} ClientSlot;
+
+// Fixed-size read slab recycled through a per-worker freelist so
+// steady-state reads perform zero allocations
+#define READ_POOL_MAX 64
+
+typedef struct ReadSlab {
+    struct ReadSlab* next;
+    char data[READ_BUFFER_SIZE];
+} ReadSlab;
+
+// Pooled write request: the uv_write_t, an inline buffer for small
+// responses, and an optional heap payload for large bodies, recycled
+// through a per-worker freelist so steady-state writes allocate nothing.
+typedef struct WriteReq {
+    uv_write_t req;
+    struct WriteReq* next;
+    struct ReavixWorker* worker;
+    char* payload;                       // heap buffer for large bodies
+    char inline_buf[WRITE_INLINE_SIZE];  // headers (+ small bodies)
+} WriteReq;
+
+// One event loop per worker thread. Each worker owns its listener (bound
+// with SO_REUSEPORT so the kernel shards accepts across workers) and its
+// own client table, so the hot path never touches a cross-thread lock.
+typedef struct ReavixWorker {
+    uv_loop_t loop;
+    uv_tcp_t server;
+    // IPC listener (PROTOCOL_IPC); bound on worker 0 only, since a
+    // Unix socket path cannot be shared the way SO_REUSEPORT ports are
+    uv_pipe_t ipc_server;
+    uv_thread_t thread;
+    int id;
+    uint16_t port;
+    ClientTable clients;
+    WriteReq* write_pool;  // freelist, touched only by this worker's loop
+    ReadSlab* read_pool;   // read-buffer freelist, same ownership rule
+    size_t read_pool_count;
+    ClientSlot* client_pool;  // handle+context freelist, same rule
+    size_t client_pool_count;
+    // Open-file cache: LRU list, most recently used first, same
+    // single-thread ownership rule as the pools above
+    struct FileCacheEntry* fc_head;
+    struct FileCacheEntry* fc_tail;
+    size_t fc_count;
+    // Dedicated WebSocket client list so broadcast fan-out skips the
+    // full connection table; touched only by this worker's loop thread
+    ClientContext* ws_head;
+    // Cross-thread fan-out: broadcast/publish push refcounted frame
+    // deliveries onto this lock-free MPSC stack from any thread and
+    // wake the loop through ws_async; the drain callback does all the
+    // actual queueing and closing on the owning loop, since libuv
+    // handles are not thread-safe
+    uv_async_t ws_async;
+    _Atomic(struct WsDelivery*) ws_inbox;
+    // Whole-worker totals (including unmatched requests); only this
+    // worker's loop thread writes them
+    uint64_t requests_handled;
+    uint64_t bytes_sent;
+    // Hashed timer wheel reaping timed-out connections in O(1) per tick
+    uv_timer_t wheel_timer;
+    ClientContext* wheel[TIMER_WHEEL_SLOTS];
+    uint64_t wheel_last_tick;
+    // Cached clock, refreshed once per second by clock_timer: the Date
+    // header pre-serialized as a full line, and a coarse wall-clock
+    // timestamp, so the hot path never calls time() or gettimeofday()
+    uv_timer_t clock_timer;
+    char date_line[48];  // "Date: Fri, 29 Aug 2026 12:00:00 GMT\r\n"
+    size_t date_line_len;
+    struct timeval wall_coarse;
+    // Pooled deflate streams, lazily initialized and reused via
+    // deflateReset() instead of a full init/teardown per response
+    z_stream deflate_gzip;
+    z_stream deflate_raw;
+    bool deflate_gzip_init;
+    bool deflate_raw_init;
+} ReavixWorker;
+
+// Token bucket with lock-free take/refill. Tokens are scaled by 1000
+// (millitokens) so fractional refill from elapsed milliseconds does not
+// round to zero between close-together requests.
+typedef struct {
+    _Atomic int64_t tokens_milli;
+    _Atomic uint64_t last_refill_ms;
+} TokenBucket;
+
+// Sealed router: the trie compiled into a contiguous arena. Nodes live
+// in one block with each node's children stored contiguously and sorted
+// by segment so lookup is a binary search per level; segments are
+// interned into a single string table. The whole structure is immutable
+// once published.
+typedef struct {
+    uint32_t segment_off;    // offset into the string table
+    uint32_t first_child;    // index of first child in nodes[]
+    uint16_t child_count;
+    int32_t param_child;     // node index, or -1
+    RouteHandler handler;
+    uint8_t handler_mode;    // ROUTE_MODE_*
+    RateLimitConfig rate_limit;
+    // Mutable island in the otherwise-immutable arena: the per-route
+    // token bucket is only ever touched through atomics
+    TokenBucket bucket;
+} SealedNode;
+
+// Per-route counters and latency histogram. One stripe per worker so
+// hot-path recording is a few unsynchronized increments; stripes are
+// summed at scrape time. Buckets are log-linear (4 sub-buckets per
+// power of two above 16us, HDR-histogram style, ~25% resolution).
+#define METRICS_HIST_BUCKETS 128
+
+typedef struct {
+    uint64_t requests;
+    uint64_t bytes_sent;
+    uint64_t hist[METRICS_HIST_BUCKETS];
+} RouteMetrics;
+
+typedef struct SealedRouter {
+    SealedNode* nodes;       // nodes[0] is the root
+    size_t node_count;
+    char* strings;
+    size_t strings_len;
+    // Mutable islands beside the immutable arena: per-worker metric
+    // stripes (MAX_WORKERS x node_count, worker-major) and the rendered
+    // route pattern per node for snapshots
+    RouteMetrics* metrics;
+    char** node_paths;
+    // Set when the arena was mapped from a snapshot file rather than
+    // built: nodes, strings and the path blob live inside the mapping
+    // and are released with munmap, not free()
+    void* map_base;
+    size_t map_len;
+    struct SealedRouter* next; // retired-list chain
+} SealedRouter;
+
+// Compiled middleware chain: reavix_use() middleware and plugin
+// pre-handlers baked, in registration order, into one flat step array
+// so per-request dispatch is an index increment and an indirect call —
+// no walk of the registration arrays and no closure allocation behind
+// next(). Rebuilt under the mutex whenever a step is registered and
+// published with the same snapshot-and-retire scheme as the router.
+typedef struct {
+    Middleware mw;          // set for reavix_use() entries...
+    PluginRequestHook hook; // ...or this, for plugin pre-handlers
+} MiddlewareStep;
+
+typedef struct MiddlewareChain {
+    MiddlewareStep steps[MAX_MIDDLEWARE + MAX_PLUGINS];
+    size_t count;
+    struct MiddlewareChain* next; // retired-list chain
+} MiddlewareChain;
+
 static struct {
     RouteEntry* routes;
     size_t route_count;
     size_t route_capacity;
     TrieNode root_node;
+    // Published immutable snapshot of root_node for lock-free matching.
+    // Writers rebuild it under the mutex; readers only atomic-load it.
+    _Atomic(TrieNode*) live_root;
+    TrieNode** retired_roots;
+    size_t retired_count;
+    size_t retired_capacity;
+    // Compiled dispatch table; preferred over live_root when non-NULL
+    _Atomic(SealedRouter*) sealed;
+    SealedRouter* retired_sealed;
     ErrorHandler error_handler;
     LogConfig log_config;
     SecurityPolicy security_policy;
@@ -37,358 +315,4165 @@ static struct {
     size_t plugin_count;
     Middleware middleware[MAX_MIDDLEWARE];
     size_t middleware_count;
+    // Compiled middleware+plugin chain; NULL while nothing is registered
+    // so request dispatch skips the machinery entirely
+    _Atomic(MiddlewareChain*) mw_chain;
+    MiddlewareChain* retired_chains;
     uint8_t enabled_protocols;
+    size_t compression_threshold;
+    // Connection deadlines, milliseconds
+    uint64_t header_timeout_ms;
+    uint64_t body_timeout_ms;
+    uint64_t idle_timeout_ms;
+    // Listener tuning, applied per worker at bind time
+    int listen_backlog;
+    int defer_accept_secs;
+    // Unix socket path for the IPC transport; NULL leaves it disabled
+    char* ipc_path;
+    // Streaming bodies: paused-stream buffer cap, plus a flag so the
+    // per-request route probe is skipped entirely when unused
+    size_t stream_watermark;
+    bool have_stream_routes;
     pthread_mutex_t mutex;
-    uv_loop_t* loop;
-    uv_tcp_t server;
-    ClientContext* clients;
-    size_t client_capacity;
+    ReavixWorker* workers;
+    size_t worker_count;
 } reavix_state;
 
-// Compression implementation
-static bool compress_data(const char* input, size_t input_len, char** output, size_t* output_len, CompressionType type) {
-    if (type == COMPRESSION_NONE || !input || !output) return false;
+// Forward declarations
+static void on_connection(uv_stream_t* server, int status);
+static void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf);
+static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf);
+static void on_client_close(uv_handle_t* handle);
+static void on_wheel_tick(uv_timer_t* timer);
+static void timer_wheel_cancel(ClientContext* ctx);
+static void on_ws_async(uv_async_t* handle);
+static void ws_client_attach(ClientContext* ctx);
+static void ws_client_detach(ClientContext* ctx);
+static bool try_websocket_upgrade(ClientContext* ctx, const Request* req);
+static void send_response(Response* res);
+static bool handler_offload(ReavixWorker* worker, Request* req, Response* res,
+                            RouteHandler handler);
+static WriteReq* write_req_acquire(ReavixWorker* worker);
+static void write_req_release(WriteReq* wr);
+static void on_pooled_write(uv_write_t* req, int status);
+static int build_response_headers(Response* res, ReavixWorker* worker,
+                                  char* dst, size_t cap, bool include_length);
+static void send_response_compressed_chunked(Response* res, CompressionType type);
+static void handle_request(Request* req, Response* res);
+static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler,
+                        uint8_t handler_mode);
+static bool trie_match(TrieNode* root, const char* path, PathParam params[],
+                       size_t* param_count, RouteHandler* out_handler,
+                       uint8_t* out_mode);
+static ClientContext* find_client_context(uv_stream_t* stream);
+static const char* get_status_text(int status_code);
+static bool client_adopt(ReavixWorker* worker, uv_stream_t* server);
+static bool ipc_bind_listener(ReavixWorker* worker);
+
+/// Client registry: open addressing with linear probing and pointer
+// hashing. Touched only by the owning worker's loop thread.
+static uint64_t client_hash(const uv_stream_t* stream) {
+    uint64_t h = (uint64_t)(uintptr_t)stream;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static bool client_table_insert(ClientTable* table, ClientContext* ctx);
+
+static bool client_table_grow(ClientTable* table) {
+    size_t new_capacity = table->capacity ? table->capacity * 2 : 16;
+    ClientContext** old_slots = table->slots;
+    size_t old_capacity = table->capacity;
+
+    table->slots = calloc(new_capacity, sizeof(ClientContext*));
+    if (!table->slots) {
+        table->slots = old_slots;
+        return false;
+    }
+    table->capacity = new_capacity;
+    table->count = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i] && old_slots[i] != CLIENT_SLOT_TOMBSTONE) {
+            client_table_insert(table, old_slots[i]);
+        }
+    }
+    free(old_slots);
+    return true;
+}
+
+static bool client_table_insert(ClientTable* table, ClientContext* ctx) {
+    if (table->count * 4 >= table->capacity * 3) {
+        if (!client_table_grow(table)) return false;
+    }
+
+    size_t mask = table->capacity - 1;
+    size_t i = (size_t)client_hash(ctx->stream) & mask;
+    while (table->slots[i] && table->slots[i] != CLIENT_SLOT_TOMBSTONE) {
+        i = (i + 1) & mask;
+    }
+    table->slots[i] = ctx;
+    table->count++;
+    return true;
+}
+
+static void client_table_remove(ClientTable* table, const uv_stream_t* stream) {
+    if (table->capacity == 0) return;
+
+    size_t mask = table->capacity - 1;
+    size_t i = (size_t)client_hash(stream) & mask;
+    while (table->slots[i]) {
+        if (table->slots[i] != CLIENT_SLOT_TOMBSTONE &&
+            table->slots[i]->stream == stream) {
+            table->slots[i] = CLIENT_SLOT_TOMBSTONE;
+            table->count--;
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+// Pre-size the table so inserts up to ~75% of `capacity` never rehash;
+// only ever grows, and rounds up to a power of two for the probe mask.
+static bool client_table_reserve(ClientTable* table, size_t capacity) {
+    size_t wanted = 16;
+    while (wanted < capacity) wanted *= 2;
+    if (wanted <= table->capacity) return true;
+
+    ClientContext** slots = calloc(wanted, sizeof(ClientContext*));
+    if (!slots) return false;
+
+    ClientContext** old_slots = table->slots;
+    size_t old_capacity = table->capacity;
+    table->slots = slots;
+    table->capacity = wanted;
+    table->count = 0;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i] && old_slots[i] != CLIENT_SLOT_TOMBSTONE) {
+            client_table_insert(table, old_slots[i]);
+        }
+    }
+    free(old_slots);
+    return true;
+}
+
+static ClientSlot* client_slot_acquire(ReavixWorker* worker) {
+    ClientSlot* slot = worker->client_pool;
+    if (slot) {
+        worker->client_pool = slot->next;
+        worker->client_pool_count--;
+        return slot;
+    }
+    return malloc(sizeof(ClientSlot));
+}
+
+static void client_slot_release(ReavixWorker* worker, ClientSlot* slot) {
+    if (worker && worker->client_pool_count < CLIENT_POOL_MAX) {
+        slot->next = worker->client_pool;
+        worker->client_pool = slot;
+        worker->client_pool_count++;
+    } else {
+        free(slot);
+    }
+}
+
+// Logging
+void reavix_log(LogLevel level, const char* trace_id, const char* fmt, ...) {
+    if (level < reavix_state.log_config.min_level) return;
+
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    if (reavix_state.log_config.custom_handler) {
+        reavix_state.log_config.custom_handler(level, message, trace_id);
+        return;
+    }
+
+    static const char* level_names[] = {
+        "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
+    };
+    if (trace_id && reavix_state.log_config.enable_tracing) {
+        fprintf(stderr, "[%s] [%s] %s\n", level_names[level], trace_id, message);
+    } else {
+        fprintf(stderr, "[%s] %s\n", level_names[level], message);
+    }
+}
+
+// Resolve the negotiated compression to what this build can actually
+// produce, so the Content-Encoding label always matches the bytes.
+static CompressionType resolve_compression(CompressionType type) {
+#ifndef REAVIX_HAVE_BROTLI
+    if (type == COMPRESSION_BROTLI) return COMPRESSION_GZIP;
+#endif
+    return type;
+}
+
+static const char* compression_encoding_name(CompressionType type) {
+    switch (type) {
+        case COMPRESSION_GZIP: return "gzip";
+        case COMPRESSION_BROTLI: return "br";
+        case COMPRESSION_DEFLATE: return "deflate";
+        default: return "";
+    }
+}
+
+// Fetch the worker's pooled deflate stream for the requested format,
+// initializing it on first use and deflateReset()-ing it otherwise.
+static z_stream* worker_deflate_stream(ReavixWorker* worker, CompressionType type) {
+    if (!worker) return NULL;
+
+    z_stream* strm = (type == COMPRESSION_GZIP) ? &worker->deflate_gzip
+                                                : &worker->deflate_raw;
+    bool* initialized = (type == COMPRESSION_GZIP) ? &worker->deflate_gzip_init
+                                                   : &worker->deflate_raw_init;
+    if (!*initialized) {
+        memset(strm, 0, sizeof(*strm));
+        int window_bits = (type == COMPRESSION_GZIP) ? 15 | 16 : 15;
+        if (deflateInit2(strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits,
+                         8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return NULL;
+        }
+        *initialized = true;
+    } else {
+        deflateReset(strm);
+    }
+    return strm;
+}
+
+// Compression implementation. Output is taken from the arena when one
+// is provided (per-connection request path), otherwise from the heap.
+// With a worker, the pooled z_stream is reused; without one a transient
+// stream is set up and torn down. On failure *output is left NULL so
+// callers never see a freed pointer.
+static bool compress_data(ReavixWorker* worker, Arena* arena,
+                          const char* input, size_t input_len,
+                          char** output, size_t* output_len, CompressionType type) {
+    if (type == COMPRESSION_NONE || !input || !output) return false;
+
+#ifdef REAVIX_HAVE_BROTLI
+    if (type == COMPRESSION_BROTLI) {
+        size_t max_output = BrotliEncoderMaxCompressedSize(input_len);
+        *output = arena ? arena_alloc(arena, max_output) : malloc(max_output);
+        if (!*output) return false;
+
+        size_t encoded_len = max_output;
+        if (!BrotliEncoderCompress(BROTLI_DEFAULT_QUALITY, BROTLI_DEFAULT_WINDOW,
+                                   BROTLI_MODE_TEXT, input_len, (const uint8_t*)input,
+                                   &encoded_len, (uint8_t*)*output)) {
+            if (!arena) free(*output);
+            *output = NULL;
+            return false;
+        }
+        *output_len = encoded_len;
+        return true;
+    }
+#endif
+
+    size_t max_output = compressBound(input_len);
+    *output = arena ? arena_alloc(arena, max_output) : malloc(max_output);
+    if (!*output) return false;
+
+    z_stream local;
+    z_stream* strm = worker_deflate_stream(worker, type);
+    if (!strm) {
+        memset(&local, 0, sizeof(local));
+        int window_bits = (type == COMPRESSION_GZIP) ? 15 | 16 : 15;
+        if (deflateInit2(&local, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits,
+                         8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            if (!arena) free(*output);
+            *output = NULL;
+            return false;
+        }
+        strm = &local;
+    }
+
+    strm->next_in = (Bytef*)input;
+    strm->avail_in = input_len;
+    strm->next_out = (Bytef*)*output;
+    strm->avail_out = max_output;
+
+    int ret = deflate(strm, Z_FINISH);
+    size_t produced = max_output - strm->avail_out;
+    if (strm == &local) deflateEnd(&local);
+    if (ret != Z_STREAM_END) {
+        if (!arena) free(*output);
+        *output = NULL;
+        return false;
+    }
+
+    *output_len = produced;
+    return true;
+}
+
+// Rate limiting implementation.
+//
+// Two layers of token buckets, both lock-free: one per sealed route
+// node, and one per client IP in a sharded open-addressing table with
+// atomic counters. Refill is computed lazily from the loop's cached
+// monotonic clock (uv_now), so the hot path makes no time syscalls.
+
+#define RL_SHARDS 16
+#define RL_SHARD_SLOTS 1024
+#define RL_PROBE_LIMIT 8
+#define RL_IDLE_REUSE_MS 60000
+
+typedef struct {
+    _Atomic uint32_t ip;  // IPv4 key in network order, 0 = empty
+    TokenBucket bucket;
+} IpBucket;
+
+static IpBucket rl_shards[RL_SHARDS][RL_SHARD_SLOTS];
+
+static int64_t rate_limit_burst_milli(const RateLimitConfig* config) {
+    uint32_t burst = config->burst_limit ? config->burst_limit
+                                         : config->requests_per_minute;
+    return (int64_t)burst * 1000;
+}
+
+// Take one token (1000 millitokens), refilling from elapsed time first.
+// The refill CAS ensures only one thread credits a given interval; the
+// burst clamp after fetch_add is racy but only ever errs by allowing a
+// briefly oversized burst, never by blocking legitimate traffic.
+static bool token_bucket_take(TokenBucket* bucket, const RateLimitConfig* config,
+                              uint64_t now_ms) {
+    int64_t burst = rate_limit_burst_milli(config);
+
+    uint64_t last = atomic_load_explicit(&bucket->last_refill_ms, memory_order_relaxed);
+    if (now_ms > last &&
+        atomic_compare_exchange_strong_explicit(&bucket->last_refill_ms, &last, now_ms,
+                                                memory_order_relaxed,
+                                                memory_order_relaxed)) {
+        int64_t refill = (int64_t)((now_ms - last) *
+            (uint64_t)config->requests_per_minute * 1000ULL / 60000ULL);
+        if (refill > 0) {
+            int64_t level = atomic_fetch_add_explicit(&bucket->tokens_milli, refill,
+                                                      memory_order_relaxed) + refill;
+            if (level > burst) {
+                atomic_store_explicit(&bucket->tokens_milli, burst, memory_order_relaxed);
+            }
+        }
+    }
+
+    if (atomic_fetch_sub_explicit(&bucket->tokens_milli, 1000,
+                                  memory_order_relaxed) >= 1000) {
+        return true;
+    }
+    atomic_fetch_add_explicit(&bucket->tokens_milli, 1000, memory_order_relaxed);
+    return false;
+}
+
+// Find (or claim) the per-IP bucket. Slots are claimed with a CAS on
+// the key; long-idle slots are recycled in place. Fails open when a
+// probe window is exhausted — overload must not turn into an outage.
+static TokenBucket* rate_limit_ip_bucket(uint32_t ip, const RateLimitConfig* config,
+                                         uint64_t now_ms) {
+    IpBucket* shard = rl_shards[(ip * 2654435761u) % RL_SHARDS];
+    size_t start = (ip >> 4) % RL_SHARD_SLOTS;
+
+    for (size_t probe = 0; probe < RL_PROBE_LIMIT; probe++) {
+        IpBucket* slot = &shard[(start + probe) % RL_SHARD_SLOTS];
+        uint32_t key = atomic_load_explicit(&slot->ip, memory_order_relaxed);
+        if (key == ip) return &slot->bucket;
+
+        bool claimable = (key == 0);
+        if (!claimable) {
+            uint64_t last = atomic_load_explicit(&slot->bucket.last_refill_ms,
+                                                 memory_order_relaxed);
+            claimable = now_ms > last && now_ms - last > RL_IDLE_REUSE_MS;
+        }
+        if (claimable &&
+            atomic_compare_exchange_strong_explicit(&slot->ip, &key, ip,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed)) {
+            atomic_store_explicit(&slot->bucket.tokens_milli,
+                                  rate_limit_burst_milli(config), memory_order_relaxed);
+            atomic_store_explicit(&slot->bucket.last_refill_ms, now_ms,
+                                  memory_order_relaxed);
+            return &slot->bucket;
+        }
+    }
+    return NULL;
+}
+
+static bool check_rate_limit(SealedNode* node, uint32_t client_ip, uint64_t now_ms) {
+    if (!node || !node->rate_limit.enabled) return true;
+
+    if (!token_bucket_take(&node->bucket, &node->rate_limit, now_ms)) {
+        return false;
+    }
+
+    if (client_ip != 0) {
+        TokenBucket* bucket = rate_limit_ip_bucket(client_ip, &node->rate_limit, now_ms);
+        if (bucket && !token_bucket_take(bucket, &node->rate_limit, now_ms)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Trie node helpers
+static TrieNode* create_trie_node(const char* segment) {
+    TrieNode* node = calloc(1, sizeof(TrieNode));
+    if (!node) return NULL;
+
+    node->segment = strdup(segment);
+    if (!node->segment) {
+        free(node);
+        return NULL;
+    }
+    return node;
+}
+
+static void free_trie_node(TrieNode* node) {
+    if (!node) return;
+
+    free(node->segment);
+
+    for (size_t i = 0; i < node->child_count; i++) {
+        free_trie_node(&node->children[i]);
+    }
+
+    free(node->children);
+    free_trie_node(node->param_child);
+    free(node);
+}
+
+// Deep-copy a trie subtree for snapshot publication
+static bool clone_trie_into(const TrieNode* src, TrieNode* dst) {
+    dst->segment = src->segment ? strdup(src->segment) : NULL;
+    dst->handler = src->handler;
+    dst->handler_mode = src->handler_mode;
+    dst->rate_limit = src->rate_limit;
+    dst->child_count = src->child_count;
+    dst->children = NULL;
+    dst->param_child = NULL;
+
+    if (src->child_count > 0) {
+        dst->children = calloc(src->child_count, sizeof(TrieNode));
+        if (!dst->children) return false;
+        for (size_t i = 0; i < src->child_count; i++) {
+            if (!clone_trie_into(&src->children[i], &dst->children[i])) return false;
+        }
+    }
+
+    if (src->param_child) {
+        dst->param_child = calloc(1, sizeof(TrieNode));
+        if (!dst->param_child || !clone_trie_into(src->param_child, dst->param_child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Publish a fresh read-only snapshot of the build trie. Caller holds
+// reavix_state.mutex. The previous snapshot may still be in use by
+// in-flight requests, so it is retired instead of freed; routes are
+// immutable after startup, so the retired list stays bounded by the
+// number of registration calls.
+static bool trie_publish(void) {
+    TrieNode* snapshot = calloc(1, sizeof(TrieNode));
+    if (!snapshot) return false;
+    if (!clone_trie_into(&reavix_state.root_node, snapshot)) {
+        free_trie_node(snapshot);
+        return false;
+    }
+
+    TrieNode* old = atomic_exchange_explicit(&reavix_state.live_root, snapshot,
+                                             memory_order_release);
+    if (old) {
+        if (reavix_state.retired_count >= reavix_state.retired_capacity) {
+            size_t new_capacity = reavix_state.retired_capacity ? reavix_state.retired_capacity * 2 : 8;
+            TrieNode** retired = realloc(reavix_state.retired_roots, new_capacity * sizeof(TrieNode*));
+            if (!retired) {
+                // Leak the old snapshot rather than free it under readers
+                return true;
+            }
+            reavix_state.retired_roots = retired;
+            reavix_state.retired_capacity = new_capacity;
+        }
+        reavix_state.retired_roots[reavix_state.retired_count++] = old;
+    }
+    return true;
+}
+
+// ---- Router sealing ----
+//
+// Compiles the pointer-chasing build trie into the SealedRouter arena:
+// one pass counts nodes, a second places them so each node's children
+// occupy a contiguous, segment-sorted block. Matching then touches one
+// or two cache lines per level and binary-searches children instead of
+// a linear strcmp scan.
+
+typedef struct {
+    SealedRouter* out;
+    size_t node_cursor;
+    size_t strings_capacity;
+} SealBuilder;
+
+static size_t seal_count_nodes(const TrieNode* node) {
+    size_t n = 1;
+    for (size_t i = 0; i < node->child_count; i++) {
+        n += seal_count_nodes(&node->children[i]);
+    }
+    if (node->param_child) {
+        n += seal_count_nodes(node->param_child);
+    }
+    return n;
+}
+
+// Intern a segment into the shared string table, reusing an existing
+// entry when possible. Linear scan is fine: sealing runs at startup.
+static uint32_t seal_intern(SealBuilder* b, const char* s) {
+    size_t len = strlen(s);
+    for (size_t off = 0; off < b->out->strings_len; ) {
+        size_t entry_len = strlen(b->out->strings + off);
+        if (entry_len == len && memcmp(b->out->strings + off, s, len) == 0) {
+            return (uint32_t)off;
+        }
+        off += entry_len + 1;
+    }
+
+    if (b->out->strings_len + len + 1 > b->strings_capacity) {
+        size_t new_capacity = b->strings_capacity ? b->strings_capacity * 2 : 256;
+        while (new_capacity < b->out->strings_len + len + 1) new_capacity *= 2;
+        char* grown = realloc(b->out->strings, new_capacity);
+        if (!grown) return UINT32_MAX;
+        b->out->strings = grown;
+        b->strings_capacity = new_capacity;
+    }
+
+    uint32_t off = (uint32_t)b->out->strings_len;
+    memcpy(b->out->strings + off, s, len + 1);
+    b->out->strings_len += len + 1;
+    return off;
+}
+
+static int seal_segment_cmp(const void* a, const void* b) {
+    const TrieNode* na = *(const TrieNode* const*)a;
+    const TrieNode* nb = *(const TrieNode* const*)b;
+    return strcmp(na->segment, nb->segment);
+}
+
+static bool seal_place(SealBuilder* b, const TrieNode* src, uint32_t node_idx) {
+    SealedNode* dst = &b->out->nodes[node_idx];
+    dst->segment_off = seal_intern(b, src->segment ? src->segment : "");
+    if (dst->segment_off == UINT32_MAX) return false;
+    dst->handler = src->handler;
+    dst->handler_mode = src->handler_mode;
+    dst->rate_limit = src->rate_limit;
+    dst->child_count = (uint16_t)src->child_count;
+    dst->first_child = 0;
+    dst->param_child = -1;
+    atomic_store_explicit(&dst->bucket.tokens_milli,
+                          rate_limit_burst_milli(&src->rate_limit), memory_order_relaxed);
+    atomic_store_explicit(&dst->bucket.last_refill_ms, 0, memory_order_relaxed);
+
+    if (src->child_count > 0) {
+        const TrieNode** order = malloc(src->child_count * sizeof(TrieNode*));
+        if (!order) return false;
+        for (size_t i = 0; i < src->child_count; i++) {
+            order[i] = &src->children[i];
+        }
+        qsort(order, src->child_count, sizeof(TrieNode*), seal_segment_cmp);
+
+        uint32_t block = (uint32_t)b->node_cursor;
+        dst->first_child = block;
+        b->node_cursor += src->child_count;
+
+        for (size_t i = 0; i < src->child_count; i++) {
+            if (!seal_place(b, order[i], block + (uint32_t)i)) {
+                free(order);
+                return false;
+            }
+        }
+        free(order);
+    }
+
+    if (src->param_child) {
+        uint32_t idx = (uint32_t)b->node_cursor++;
+        dst->param_child = (int32_t)idx;
+        if (!seal_place(b, src->param_child, idx)) return false;
+    }
+    return true;
+}
+
+static void sealed_free(SealedRouter* sr) {
+    if (!sr) return;
+    if (sr->map_base) {
+        // Snapshot-backed: node_paths entries point into the mapping
+        munmap(sr->map_base, sr->map_len);
+        free(sr->node_paths);
+        free(sr->metrics);
+        free(sr);
+        return;
+    }
+    if (sr->node_paths) {
+        for (size_t i = 0; i < sr->node_count; i++) free(sr->node_paths[i]);
+        free(sr->node_paths);
+    }
+    free(sr->metrics);
+    free(sr->nodes);
+    free(sr->strings);
+    free(sr);
+}
+
+// Render the full route pattern of every sealed node (param segments
+// keep their ':' spelling) for metrics output. Startup-only recursion.
+static bool seal_render_paths(SealedRouter* sr, uint32_t idx, const char* prefix) {
+    SealedNode* node = &sr->nodes[idx];
+    const char* segment = sr->strings + node->segment_off;
+
+    char* path;
+    if (idx == 0) {
+        path = strdup("/");
+    } else {
+        size_t len = strlen(prefix) + strlen(segment) + 2;
+        path = malloc(len);
+        if (path) snprintf(path, len, "%s/%s", prefix, segment);
+    }
+    if (!path) return false;
+    sr->node_paths[idx] = path;
+
+    const char* child_prefix = (idx == 0) ? "" : path;
+    for (uint16_t i = 0; i < node->child_count; i++) {
+        if (!seal_render_paths(sr, node->first_child + i, child_prefix)) return false;
+    }
+    if (node->param_child >= 0) {
+        if (!seal_render_paths(sr, (uint32_t)node->param_child, child_prefix)) return false;
+    }
+    return true;
+}
+
+// Caller holds reavix_state.mutex
+static bool router_seal_locked(void) {
+    size_t count = seal_count_nodes(&reavix_state.root_node);
+
+    SealedRouter* sr = calloc(1, sizeof(SealedRouter));
+    if (!sr) return false;
+    sr->nodes = calloc(count, sizeof(SealedNode));
+    if (!sr->nodes) {
+        free(sr);
+        return false;
+    }
+    sr->node_count = count;
+
+    SealBuilder builder = { .out = sr, .node_cursor = 1, .strings_capacity = 0 };
+    if (!seal_place(&builder, &reavix_state.root_node, 0)) {
+        sealed_free(sr);
+        return false;
+    }
+
+    sr->metrics = calloc((size_t)MAX_WORKERS * count, sizeof(RouteMetrics));
+    sr->node_paths = calloc(count, sizeof(char*));
+    if (!sr->metrics || !sr->node_paths ||
+        !seal_render_paths(sr, 0, "")) {
+        sealed_free(sr);
+        return false;
+    }
+
+    SealedRouter* old = atomic_exchange_explicit(&reavix_state.sealed, sr,
+                                                 memory_order_release);
+    if (old) {
+        // Retire rather than free: in-flight readers may still hold it
+        old->next = reavix_state.retired_sealed;
+        reavix_state.retired_sealed = old;
+    }
+    return true;
+}
+
+bool reavix_router_seal(void) {
+    pthread_mutex_lock(&reavix_state.mutex);
+    bool ok = router_seal_locked();
+    pthread_mutex_unlock(&reavix_state.mutex);
+    return ok;
+}
+
+// Binary route-table snapshots.
+//
+// The sealed arena is already position-independent — nodes reference
+// each other by index and segments by string-table offset — so it can
+// be written out nearly verbatim and mapped straight back at boot,
+// skipping trie construction and sealing entirely. Only the two things
+// that cannot survive a restart are scrubbed on the way out: handler
+// function pointers (NULLed; rebinding happens via reavix_route, keyed
+// by the rendered route pattern) and the token-bucket atomics
+// (re-initialized at load). The mapping is MAP_PRIVATE, so untouched
+// pages — the entire string and path blobs, and every node page no
+// handler lands on — stay shared copy-on-write between instances
+// mapping the same file. Snapshots are build-specific: sizeof
+// (SealedNode) is recorded and checked so a stale file from another
+// build is rejected rather than misread.
+#define SNAPSHOT_MAGIC "RVXSEAL1"
+#define SNAPSHOT_VERSION 1u
+#define SNAPSHOT_PAGE 4096u
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t node_count;
+    uint64_t node_size;    // sizeof(SealedNode) guard against ABI drift
+    uint64_t nodes_off;    // page-aligned
+    uint64_t strings_off;
+    uint64_t strings_len;
+    uint64_t paths_off;    // node_count NUL-terminated patterns, node order
+    uint64_t paths_len;
+} SnapshotHeader;
+
+bool reavix_router_snapshot_save(const char* file) {
+    pthread_mutex_lock(&reavix_state.mutex);
+    SealedRouter* sr = atomic_load_explicit(&reavix_state.sealed, memory_order_acquire);
+    if (!sr || !file) {
+        pthread_mutex_unlock(&reavix_state.mutex);
+        return false;
+    }
+
+    size_t paths_len = 0;
+    for (size_t i = 0; i < sr->node_count; i++) {
+        paths_len += strlen(sr->node_paths[i]) + 1;
+    }
+
+    SnapshotHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, 8);
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.node_count = (uint32_t)sr->node_count;
+    hdr.node_size = sizeof(SealedNode);
+    hdr.nodes_off = (sizeof(SnapshotHeader) + SNAPSHOT_PAGE - 1) &
+                    ~(uint64_t)(SNAPSHOT_PAGE - 1);
+    hdr.strings_off = hdr.nodes_off + (uint64_t)sr->node_count * sizeof(SealedNode);
+    hdr.strings_len = sr->strings_len;
+    hdr.paths_off = hdr.strings_off + hdr.strings_len;
+    hdr.paths_len = paths_len;
+
+    FILE* f = fopen(file, "wb");
+    if (!f) {
+        pthread_mutex_unlock(&reavix_state.mutex);
+        return false;
+    }
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+    for (size_t pad = sizeof(hdr); ok && pad < hdr.nodes_off; pad++) {
+        ok = fputc(0, f) != EOF;
+    }
+    for (size_t i = 0; ok && i < sr->node_count; i++) {
+        SealedNode scrubbed;
+        memcpy(&scrubbed, &sr->nodes[i], sizeof(scrubbed));
+        scrubbed.handler = NULL;
+        memset(&scrubbed.bucket, 0, sizeof(scrubbed.bucket));
+        ok = fwrite(&scrubbed, sizeof(scrubbed), 1, f) == 1;
+    }
+    if (ok && sr->strings_len > 0) {
+        ok = fwrite(sr->strings, sr->strings_len, 1, f) == 1;
+    }
+    for (size_t i = 0; ok && i < sr->node_count; i++) {
+        ok = fwrite(sr->node_paths[i], strlen(sr->node_paths[i]) + 1, 1, f) == 1;
+    }
+
+    if (fclose(f) != 0) ok = false;
+    if (!ok) unlink(file);
+    pthread_mutex_unlock(&reavix_state.mutex);
+    return ok;
+}
+
+bool reavix_router_snapshot_load(const char* file) {
+    if (!file) return false;
+
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return false;
+    }
+    size_t map_len = (size_t)st.st_size;
+
+    // MAP_PRIVATE read-write: handler rebinding and token-bucket state
+    // dirty only the pages they touch; everything else stays shared
+    void* map = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const SnapshotHeader* hdr = map;
+    if (memcmp(hdr->magic, SNAPSHOT_MAGIC, 8) != 0 ||
+        hdr->version != SNAPSHOT_VERSION ||
+        hdr->node_size != sizeof(SealedNode) ||
+        hdr->node_count == 0 ||
+        hdr->nodes_off + (uint64_t)hdr->node_count * sizeof(SealedNode) != hdr->strings_off ||
+        hdr->strings_off + hdr->strings_len != hdr->paths_off ||
+        hdr->paths_off + hdr->paths_len != map_len ||
+        hdr->strings_len == 0 || hdr->paths_len == 0) {
+        munmap(map, map_len);
+        return false;
+    }
+
+    SealedNode* nodes = (SealedNode*)((char*)map + hdr->nodes_off);
+    char* strings = (char*)map + hdr->strings_off;
+    char* paths = (char*)map + hdr->paths_off;
+
+    // A corrupt or truncated snapshot must fail load, not crash a
+    // worker later: check every offset the match path will follow
+    bool sane = strings[hdr->strings_len - 1] == '\0' &&
+                paths[hdr->paths_len - 1] == '\0';
+    for (size_t i = 0; sane && i < hdr->node_count; i++) {
+        SealedNode* n = &nodes[i];
+        sane = n->segment_off < hdr->strings_len &&
+               (uint64_t)n->first_child + n->child_count <= hdr->node_count &&
+               n->param_child < (int32_t)hdr->node_count;
+    }
+    if (!sane) {
+        munmap(map, map_len);
+        return false;
+    }
+
+    SealedRouter* sr = calloc(1, sizeof(SealedRouter));
+    if (!sr) {
+        munmap(map, map_len);
+        return false;
+    }
+    sr->nodes = nodes;
+    sr->node_count = hdr->node_count;
+    sr->strings = strings;
+    sr->strings_len = hdr->strings_len;
+    sr->map_base = map;
+    sr->map_len = map_len;
+    sr->metrics = calloc((size_t)MAX_WORKERS * hdr->node_count, sizeof(RouteMetrics));
+    sr->node_paths = calloc(hdr->node_count, sizeof(char*));
+    if (!sr->metrics || !sr->node_paths) {
+        sealed_free(sr);
+        return false;
+    }
+
+    // Thread node_paths through the blob; one pattern per node, in order
+    char* p = paths;
+    char* paths_end = paths + hdr->paths_len;
+    for (size_t i = 0; i < hdr->node_count; i++) {
+        if (p >= paths_end) {
+            sealed_free(sr);
+            return false;
+        }
+        sr->node_paths[i] = p;
+        p += strlen(p) + 1;
+    }
+
+    // Handlers cannot survive a restart; buckets restart full
+    for (size_t i = 0; i < hdr->node_count; i++) {
+        nodes[i].handler = NULL;
+        atomic_store_explicit(&nodes[i].bucket.tokens_milli,
+                              rate_limit_burst_milli(&nodes[i].rate_limit),
+                              memory_order_relaxed);
+        atomic_store_explicit(&nodes[i].bucket.last_refill_ms, 0, memory_order_relaxed);
+    }
+
+    pthread_mutex_lock(&reavix_state.mutex);
+    SealedRouter* old = atomic_exchange_explicit(&reavix_state.sealed, sr,
+                                                 memory_order_release);
+    if (old) {
+        old->next = reavix_state.retired_sealed;
+        reavix_state.retired_sealed = old;
+    }
+    pthread_mutex_unlock(&reavix_state.mutex);
+    return true;
+}
+
+// Bind a handler into a snapshot-loaded table by its route pattern.
+// node_paths keeps the ':' spelling, so the path as registered matches
+// byte-for-byte; a route the snapshot does not know falls back to a
+// full re-seal in the caller. The single word store is safe against
+// lock-free readers, which see either NULL (404) or the handler.
+static bool sealed_rebind(SealedRouter* sr, const char* path,
+                          RouteHandler handler, uint8_t handler_mode) {
+    for (size_t i = 0; i < sr->node_count; i++) {
+        if (strcmp(sr->node_paths[i], path) == 0) {
+            sr->nodes[i].handler_mode = handler_mode;
+            sr->nodes[i].handler = handler;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Caller holds reavix_state.mutex. Bakes the middleware array and the
+// plugins' pre-handlers into a fresh chain; publishes NULL when there
+// are no steps at all. On allocation failure the previous chain stays
+// published, matching how a failed re-seal keeps the old table.
+static void middleware_compile_locked(void) {
+    MiddlewareChain* chain = calloc(1, sizeof(MiddlewareChain));
+    if (!chain) return;
+
+    for (size_t i = 0; i < reavix_state.middleware_count; i++) {
+        chain->steps[chain->count++].mw = reavix_state.middleware[i];
+    }
+    for (size_t i = 0; i < reavix_state.plugin_count; i++) {
+        if (reavix_state.plugins[i].pre_handler) {
+            chain->steps[chain->count++].hook = reavix_state.plugins[i].pre_handler;
+        }
+    }
+    if (chain->count == 0) {
+        free(chain);
+        chain = NULL;
+    }
+
+    MiddlewareChain* old = atomic_exchange_explicit(&reavix_state.mw_chain, chain,
+                                                    memory_order_release);
+    if (old) {
+        // Retire rather than free: in-flight requests may still hold it
+        old->next = reavix_state.retired_chains;
+        reavix_state.retired_chains = old;
+    }
+}
+
+// Match against the sealed arena. Same contract as trie_match(): zero
+// allocations, params captured as views into the caller's path buffer.
+// out_node (optional) receives the matched node so callers can reach
+// its rate-limit bucket.
+static bool sealed_match(SealedRouter* sr, const char* path, PathParam params[],
+                         size_t* param_count, RouteHandler* out_handler,
+                         SealedNode** out_node) {
+    const char* p = path;
+    SealedNode* current = &sr->nodes[0];
+    size_t param_index = 0;
+
+    while (*p) {
+        while (*p == '/') p++;
+        if (!*p) break;
+
+        const char* segment = p;
+        while (*p && *p != '/') p++;
+        size_t segment_len = (size_t)(p - segment);
+
+        // Binary search the sorted child block
+        SealedNode* next = NULL;
+        size_t lo = 0;
+        size_t hi = current->child_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            SealedNode* child = &sr->nodes[current->first_child + mid];
+            const char* child_segment = sr->strings + child->segment_off;
+            int c = strncmp(child_segment, segment, segment_len);
+            if (c == 0) c = (unsigned char)child_segment[segment_len];
+            if (c == 0) {
+                next = child;
+                break;
+            }
+            if (c < 0) lo = mid + 1;
+            else hi = mid;
+        }
+
+        if (!next) {
+            if (current->param_child >= 0 && param_index < MAX_PARAMS) {
+                SealedNode* param_node = &sr->nodes[current->param_child];
+                params[param_index].name = sr->strings + param_node->segment_off + 1;
+                params[param_index].value = segment;
+                params[param_index].value_len = segment_len;
+                param_index++;
+                next = param_node;
+            } else {
+                return false;
+            }
+        }
+        current = next;
+    }
+
+    *param_count = param_index;
+    *out_handler = current->handler;
+    if (out_node) *out_node = current;
+    return current->handler != NULL;
+}
+
+// Metrics recording and aggregation.
+
+// Map a microsecond latency to its log-linear bucket.
+static int metrics_bucket(uint64_t us) {
+    if (us < 16) return (int)us;
+    int exp = 63 - __builtin_clzll(us);
+    int idx = 16 + (exp - 4) * 4 + (int)((us >> (exp - 2)) & 3);
+    return idx < METRICS_HIST_BUCKETS ? idx : METRICS_HIST_BUCKETS - 1;
+}
+
+// Midpoint of a bucket's value range, for quantile readout.
+static uint64_t metrics_bucket_value(int idx) {
+    if (idx < 16) return (uint64_t)idx;
+    int exp = 4 + (idx - 16) / 4;
+    int sub = (idx - 16) & 3;
+    return (1ULL << exp) + ((uint64_t)sub << (exp - 2)) + (1ULL << (exp - 3));
+}
+
+static uint64_t metrics_hist_quantile(const uint64_t* hist, uint64_t total, double q) {
+    if (total == 0) return 0;
+    uint64_t target = (uint64_t)(q * (double)(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= target) return metrics_bucket_value(b);
+    }
+    return metrics_bucket_value(METRICS_HIST_BUCKETS - 1);
+}
+
+// Hot path: bump the worker's own stripe, nothing shared, no atomics.
+static void metrics_record(ReavixWorker* worker, SealedRouter* sr, SealedNode* node,
+                           uint64_t elapsed_us, size_t bytes) {
+    if (!worker) return;
+    worker->requests_handled++;
+    worker->bytes_sent += bytes;
+
+    if (!sr || !sr->metrics || !node) return;
+    size_t idx = (size_t)(node - sr->nodes);
+    RouteMetrics* m = &sr->metrics[(size_t)worker->id * sr->node_count + idx];
+    m->requests++;
+    m->bytes_sent += bytes;
+    m->hist[metrics_bucket(elapsed_us)]++;
+}
+
+size_t reavix_metrics_snapshot(ReavixRouteMetrics* out, size_t max_routes) {
+    if (!out) return 0;
+    SealedRouter* sr = atomic_load_explicit(&reavix_state.sealed, memory_order_acquire);
+    if (!sr || !sr->metrics) return 0;
+
+    size_t filled = 0;
+    for (size_t i = 0; i < sr->node_count && filled < max_routes; i++) {
+        if (!sr->nodes[i].handler) continue;
+
+        ReavixRouteMetrics* rm = &out[filled];
+        memset(rm, 0, sizeof(*rm));
+        rm->route = sr->node_paths[i];
+
+        uint64_t hist[METRICS_HIST_BUCKETS] = {0};
+        uint64_t hist_total = 0;
+        for (size_t w = 0; w < reavix_state.worker_count; w++) {
+            RouteMetrics* m = &sr->metrics[w * sr->node_count + i];
+            rm->requests += m->requests;
+            rm->bytes_sent += m->bytes_sent;
+            for (int b = 0; b < METRICS_HIST_BUCKETS; b++) {
+                hist[b] += m->hist[b];
+                hist_total += m->hist[b];
+            }
+        }
+        rm->p50_us = metrics_hist_quantile(hist, hist_total, 0.50);
+        rm->p99_us = metrics_hist_quantile(hist, hist_total, 0.99);
+        rm->p999_us = metrics_hist_quantile(hist, hist_total, 0.999);
+        filled++;
+    }
+    return filled;
+}
+
+// Built-in /metrics text endpoint (Prometheus exposition style),
+// served when no user route claims the path.
+#define METRICS_MAX_ROUTES 256
+
+// Format one exposition line and write however much of it fit.
+// snprintf returns the would-be length on truncation, so the count is
+// clamped to what is actually in the buffer before res_write sees it.
+static void metrics_write_line(Response* res, char* line, size_t cap,
+                               const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, cap, fmt, args);
+    va_end(args);
+    if (len <= 0) return;
+    if ((size_t)len >= cap) len = (int)(cap - 1);
+    res_write(res, line, (size_t)len);
+}
+
+static void metrics_render(Response* res) {
+    ReavixRouteMetrics routes[METRICS_MAX_ROUTES];
+    size_t n = reavix_metrics_snapshot(routes, METRICS_MAX_ROUTES);
+
+    char line[512];
+    for (size_t i = 0; i < n; i++) {
+        metrics_write_line(res, line, sizeof(line),
+            "reavix_requests_total{route=\"%s\"} %llu\n",
+            routes[i].route, (unsigned long long)routes[i].requests);
+        metrics_write_line(res, line, sizeof(line),
+            "reavix_bytes_sent_total{route=\"%s\"} %llu\n",
+            routes[i].route, (unsigned long long)routes[i].bytes_sent);
+        metrics_write_line(res, line, sizeof(line),
+            "reavix_request_latency_us{route=\"%s\",quantile=\"0.5\"} %llu\n",
+            routes[i].route, (unsigned long long)routes[i].p50_us);
+        metrics_write_line(res, line, sizeof(line),
+            "reavix_request_latency_us{route=\"%s\",quantile=\"0.99\"} %llu\n",
+            routes[i].route, (unsigned long long)routes[i].p99_us);
+        metrics_write_line(res, line, sizeof(line),
+            "reavix_request_latency_us{route=\"%s\",quantile=\"0.999\"} %llu\n",
+            routes[i].route, (unsigned long long)routes[i].p999_us);
+    }
+
+    // Whole-server totals and queue-depth gauges
+    uint64_t requests = 0;
+    uint64_t bytes = 0;
+    size_t connections = 0;
+    for (size_t w = 0; w < reavix_state.worker_count; w++) {
+        requests += reavix_state.workers[w].requests_handled;
+        bytes += reavix_state.workers[w].bytes_sent;
+        connections += reavix_state.workers[w].clients.count;
+    }
+    metrics_write_line(res, line, sizeof(line),
+        "reavix_requests_handled_total %llu\n"
+        "reavix_bytes_sent_bytes_total %llu\n"
+        "reavix_open_connections %zu\n",
+        (unsigned long long)requests, (unsigned long long)bytes, connections);
+
+    res_set_header(res, "Content-Type", "text/plain; version=0.0.4");
+    send_response(res);
+}
+
+// Initialize the framework
+bool reavix_init(size_t max_routes) {
+    if (max_routes == 0) return false;
+
+    memset(&reavix_state, 0, sizeof(reavix_state));
+    reavix_state.route_capacity = max_routes;
+    reavix_state.routes = malloc(max_routes * sizeof(RouteEntry));
+    if (!reavix_state.routes) return false;
+
+    pthread_mutex_init(&reavix_state.mutex, NULL);
+    reavix_state.enabled_protocols = PROTOCOL_HTTP; // HTTP enabled by default
+    reavix_state.compression_threshold = COMPRESSION_MIN_SIZE;
+    reavix_state.header_timeout_ms = 10000;
+    reavix_state.body_timeout_ms = 30000;
+    reavix_state.idle_timeout_ms = 60000;
+    reavix_state.stream_watermark = STREAM_WATERMARK_DEFAULT;
+    parser_init();  // pick the SIMD parser implementation for this CPU
+
+    // Initialize root node
+    reavix_state.root_node.segment = strdup("");
+    reavix_state.root_node.handler = NULL;
+    reavix_state.root_node.children = NULL;
+    reavix_state.root_node.param_child = NULL;
+    reavix_state.root_node.child_count = 0;
+
+    return true;
+}
+
+// Route registration with rate limiting
+static bool route_register(const char* method, const char* path,
+                           RouteHandler handler, uint8_t handler_mode) {
+    if (!method || !path || !handler) return false;
+
+    pthread_mutex_lock(&reavix_state.mutex);
+
+    if (reavix_state.route_count >= reavix_state.route_capacity) {
+        pthread_mutex_unlock(&reavix_state.mutex);
+        return false;
+    }
+
+    // Check for duplicate routes
+    for (size_t i = 0; i < reavix_state.route_count; ++i) {
+        if (strcmp(reavix_state.routes[i].method, method) == 0 &&
+            strcmp(reavix_state.routes[i].path, path) == 0) {
+            pthread_mutex_unlock(&reavix_state.mutex);
+            return false;
+        }
+    }
+
+    // Add to flat route list
+    reavix_state.routes[reavix_state.route_count].method = strdup(method);
+    reavix_state.routes[reavix_state.route_count].path = strdup(path);
+    reavix_state.routes[reavix_state.route_count].handler = handler;
+    reavix_state.route_count++;
+
+    // Add to trie router
+    if (!trie_insert(&reavix_state.root_node, path, handler, handler_mode)) {
+        pthread_mutex_unlock(&reavix_state.mutex);
+        return false;
+    }
+    if (handler_mode == ROUTE_MODE_STREAM) {
+        reavix_state.have_stream_routes = true;
+    }
+
+    // Publish the updated trie for lock-free readers
+    bool published = trie_publish();
+
+    // Keep the compiled table current if the router was already sealed.
+    // With a snapshot-loaded table the route usually already exists
+    // with a NULL handler — bind it in place and keep the mapping;
+    // only a route the snapshot never saw forces a rebuild.
+    SealedRouter* sealed = atomic_load_explicit(&reavix_state.sealed, memory_order_relaxed);
+    if (published && sealed &&
+        !(sealed->map_base && sealed_rebind(sealed, path, handler, handler_mode))) {
+        published = router_seal_locked();
+    }
+
+    pthread_mutex_unlock(&reavix_state.mutex);
+    return published;
+}
+
+bool reavix_route(const char* method, const char* path, RouteHandler handler) {
+    return route_register(method, path, handler, ROUTE_MODE_SYNC);
+}
+
+bool reavix_route_async(const char* method, const char* path, RouteHandler handler) {
+    return route_register(method, path, handler, ROUTE_MODE_ASYNC);
+}
+
+bool reavix_route_work(const char* method, const char* path, RouteHandler handler) {
+    return route_register(method, path, handler, ROUTE_MODE_WORK);
+}
+
+bool reavix_route_stream(const char* method, const char* path, RouteHandler handler) {
+    return route_register(method, path, handler, ROUTE_MODE_STREAM);
+}
+
+// Server implementation.
+//
+// Each worker binds its own listening socket with SO_REUSEPORT, so the
+// kernel load-balances incoming connections across worker loops and no
+// accept mutex is needed. uv_tcp_bind() has no reuseport flag, so the
+// socket is created eagerly with uv_tcp_init_ex() and the option is set
+// on the raw fd before binding.
+static bool worker_bind_listener(ReavixWorker* worker) {
+    struct sockaddr_in addr;
+    uv_ip4_addr("0.0.0.0", worker->port, &addr);
+
+    if (uv_tcp_init_ex(&worker->loop, &worker->server, AF_INET) != 0) {
+        return false;
+    }
+    worker->server.data = worker;
+
+    uv_os_fd_t fd;
+    if (uv_fileno((uv_handle_t*)&worker->server, &fd) == 0) {
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#ifdef TCP_DEFER_ACCEPT
+        // Defer the accept wakeup until the client's first data arrives,
+        // so idle half-open connections never cost a loop iteration
+        if (reavix_state.defer_accept_secs > 0) {
+            setsockopt(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT,
+                       &reavix_state.defer_accept_secs,
+                       sizeof(reavix_state.defer_accept_secs));
+        }
+#endif
+    }
+
+    if (uv_tcp_bind(&worker->server, (const struct sockaddr*)&addr, 0) != 0) {
+        return false;
+    }
+
+    int backlog = reavix_state.listen_backlog > 0 ? reavix_state.listen_backlog
+                                                  : SOMAXCONN;
+    int r = uv_listen((uv_stream_t*)&worker->server, backlog, on_connection);
+    if (r) {
+        reavix_log(LOG_FATAL, NULL, "Worker %d listen error: %s", worker->id, uv_strerror(r));
+        return false;
+    }
+
+    // Reserve the client table and prewarm the slot freelist up front so
+    // the accept path performs no allocator work even on a cold start
+    client_table_reserve(&worker->clients, CLIENT_TABLE_INITIAL);
+    for (size_t i = worker->client_pool_count; i < CLIENT_POOL_MAX; i++) {
+        ClientSlot* slot = malloc(sizeof(ClientSlot));
+        if (!slot) break;
+        slot->next = worker->client_pool;
+        worker->client_pool = slot;
+        worker->client_pool_count++;
+    }
+    return true;
+}
+
+// Refresh the worker's cached clock: the pre-serialized RFC 7231 Date
+// line and the coarse wall-clock timestamp. Runs once per second, so
+// per-request code reads the cache instead of making a syscall.
+static void worker_clock_refresh(ReavixWorker* worker) {
+    gettimeofday(&worker->wall_coarse, NULL);
+
+    time_t now = worker->wall_coarse.tv_sec;
+    struct tm tm;
+    gmtime_r(&now, &tm);
+    worker->date_line_len = strftime(worker->date_line, sizeof(worker->date_line),
+                                     "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &tm);
+}
+
+static void on_clock_tick(uv_timer_t* timer) {
+    worker_clock_refresh(timer->data);
+}
+
+static void worker_thread(void* arg) {
+    ReavixWorker* worker = arg;
+
+    uv_timer_init(&worker->loop, &worker->wheel_timer);
+    worker->wheel_timer.data = worker;
+    worker->wheel_last_tick = uv_now(&worker->loop) / TIMER_WHEEL_TICK_MS;
+    uv_timer_start(&worker->wheel_timer, on_wheel_tick,
+                   TIMER_WHEEL_TICK_MS, TIMER_WHEEL_TICK_MS);
+    uv_unref((uv_handle_t*)&worker->wheel_timer);  // don't hold the loop open
+
+    uv_timer_init(&worker->loop, &worker->clock_timer);
+    worker->clock_timer.data = worker;
+    worker_clock_refresh(worker);  // valid before the first tick
+    uv_timer_start(&worker->clock_timer, on_clock_tick, 1000, 1000);
+    uv_unref((uv_handle_t*)&worker->clock_timer);
+
+    uv_async_init(&worker->loop, &worker->ws_async, on_ws_async);
+    worker->ws_async.data = worker;
+    uv_unref((uv_handle_t*)&worker->ws_async);
+
+    uv_run(&worker->loop, UV_RUN_DEFAULT);
+}
+
+void reavix_server_threaded(uint16_t port, size_t n_workers) {
+    if (n_workers == 0) n_workers = 1;
+    if (n_workers > MAX_WORKERS) n_workers = MAX_WORKERS;
+
+    reavix_state.workers = calloc(n_workers, sizeof(ReavixWorker));
+    if (!reavix_state.workers) {
+        reavix_log(LOG_FATAL, NULL, "Failed to allocate %zu workers", n_workers);
+        return;
+    }
+    reavix_state.worker_count = n_workers;
+
+    for (size_t i = 0; i < n_workers; i++) {
+        ReavixWorker* worker = &reavix_state.workers[i];
+        worker->id = (int)i;
+        worker->port = port;
+        uv_loop_init(&worker->loop);
+
+        if (!worker_bind_listener(worker)) {
+            reavix_log(LOG_FATAL, NULL, "Worker %d failed to bind port %d", worker->id, port);
+            return;
+        }
+    }
+
+    if ((reavix_state.enabled_protocols & PROTOCOL_IPC) && reavix_state.ipc_path) {
+        if (ipc_bind_listener(&reavix_state.workers[0])) {
+            reavix_log(LOG_INFO, NULL, "IPC transport on %s", reavix_state.ipc_path);
+        } else {
+            // TCP service is unaffected; same-host callers fall back to it
+            reavix_log(LOG_ERROR, NULL, "Failed to bind IPC socket %s",
+                       reavix_state.ipc_path);
+        }
+    }
+
+    reavix_log(LOG_INFO, NULL, "Server running on port %d (%zu workers)", port, n_workers);
+
+    // Workers 1..n-1 run on their own threads; worker 0 runs on the
+    // caller's thread so reavix_server_threaded() blocks like reavix_server().
+    for (size_t i = 1; i < n_workers; i++) {
+        uv_thread_create(&reavix_state.workers[i].thread, worker_thread, &reavix_state.workers[i]);
+    }
+    worker_thread(&reavix_state.workers[0]);
+
+    for (size_t i = 1; i < n_workers; i++) {
+        uv_thread_join(&reavix_state.workers[i].thread);
+    }
+}
+
+void reavix_server(uint16_t port) {
+    reavix_server_threaded(port, 1);
+}
+
+// Connection deadlines: a hashed timer wheel per worker, driven by one
+// coarse uv_timer per loop. Each connection sits in at most one wheel
+// slot (hashed by its deadline), so arming and cancelling are O(1) and
+// a tick only visits the slots whose turn came up — no per-connection
+// uv_timer_t, which degrades loop latency at tens of thousands of
+// handles.
+
+static void timer_wheel_cancel(ClientContext* ctx) {
+    if (ctx->wheel_slot < 0) return;
+    ReavixWorker* worker = ctx->worker;
+    if (ctx->wheel_prev) ctx->wheel_prev->wheel_next = ctx->wheel_next;
+    else worker->wheel[ctx->wheel_slot] = ctx->wheel_next;
+    if (ctx->wheel_next) ctx->wheel_next->wheel_prev = ctx->wheel_prev;
+    ctx->wheel_prev = NULL;
+    ctx->wheel_next = NULL;
+    ctx->wheel_slot = -1;
+}
+
+static void timer_wheel_schedule(ClientContext* ctx, uint64_t timeout_ms) {
+    ReavixWorker* worker = ctx->worker;
+    timer_wheel_cancel(ctx);
+
+    ctx->deadline_ms = uv_now(&worker->loop) + timeout_ms;
+    int slot = (int)((ctx->deadline_ms / TIMER_WHEEL_TICK_MS) & (TIMER_WHEEL_SLOTS - 1));
+    ctx->wheel_slot = slot;
+    ctx->wheel_prev = NULL;
+    ctx->wheel_next = worker->wheel[slot];
+    if (worker->wheel[slot]) worker->wheel[slot]->wheel_prev = ctx;
+    worker->wheel[slot] = ctx;
+}
+
+static void on_wheel_tick(uv_timer_t* timer) {
+    ReavixWorker* worker = timer->data;
+    uint64_t now = uv_now(&worker->loop);
+    uint64_t cur = now / TIMER_WHEEL_TICK_MS;
+    uint64_t from = worker->wheel_last_tick + 1;
+    if (cur >= TIMER_WHEEL_SLOTS && from < cur - TIMER_WHEEL_SLOTS + 1) {
+        from = cur - TIMER_WHEEL_SLOTS + 1;  // a full rotation covers all slots
+    }
+
+    for (uint64_t t = from; t <= cur; t++) {
+        ClientContext* ctx = worker->wheel[t & (TIMER_WHEEL_SLOTS - 1)];
+        while (ctx) {
+            ClientContext* next = ctx->wheel_next;
+            // Entries hashed here from an earlier rotation survive
+            if (ctx->deadline_ms <= now) {
+                timer_wheel_cancel(ctx);
+                reavix_log(LOG_DEBUG, NULL, "Reaping timed-out connection");
+                if (!uv_is_closing((uv_handle_t*)ctx->stream)) {
+                    uv_close((uv_handle_t*)ctx->stream, on_client_close);
+                }
+            }
+            ctx = next;
+        }
+    }
+    worker->wheel_last_tick = cur;
+}
+
+// Re-arm a connection's deadline after progress: idle keep-alive
+// between requests, the header deadline while a request's headers are
+// still partial, the body deadline once they are complete. Upgraded
+// WebSocket connections are push channels and are left unarmed, as are
+// connections waiting on a deferred handler or an in-flight sendfile:
+// their completion paths (res_complete, file_send_finish) re-arm the
+// deadline, and reaping them mid-flight would free the arena under the
+// pending response.
+static void connection_arm_deadline(ClientContext* ctx) {
+    if (ctx->is_websocket || ctx->async_pending || ctx->file_send) {
+        timer_wheel_cancel(ctx);
+    } else if (ctx->body_stream) {
+        timer_wheel_schedule(ctx, reavix_state.body_timeout_ms);
+    } else if (ctx->inbuf_len == 0) {
+        timer_wheel_schedule(ctx, reavix_state.idle_timeout_ms);
+    } else if (parser_find_headers_end(ctx->inbuf, ctx->inbuf_len) == 0) {
+        timer_wheel_schedule(ctx, reavix_state.header_timeout_ms);
+    } else {
+        timer_wheel_schedule(ctx, reavix_state.body_timeout_ms);
+    }
+}
+
+// Connection handler
+// Close callback for a handle whose accept failed: the context was never
+// attached, so only the slot itself needs recycling.
+static void on_slot_abandoned(uv_handle_t* handle) {
+    ClientSlot* slot = (ClientSlot*)handle;
+    client_slot_release(slot->ctx.worker, slot);
+}
+
+// Accept one pending connection from `server` — the TCP listener, or
+// the IPC pipe when a peer passes an established socket across it —
+// and set it up as a regular HTTP client on this worker. Returns false
+// once nothing is pending.
+static bool client_adopt(ReavixWorker* worker, uv_stream_t* server) {
+    ClientSlot* slot = client_slot_acquire(worker);
+    if (!slot) return false;
+
+    uv_tcp_init(&worker->loop, &slot->handle);
+    slot->handle.data = NULL;
+    slot->ctx.worker = worker;  // for on_slot_abandoned
+
+    if (uv_accept(server, (uv_stream_t*)&slot->handle) != 0) {
+        uv_close((uv_handle_t*)&slot->handle, on_slot_abandoned);
+        return false;
+    }
+
+    uv_tcp_t* client = &slot->handle;
+    ClientContext* ctx = &slot->ctx;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->stream = (uv_stream_t*)client;
+    ctx->wheel_slot = -1;
+    ctx->worker = worker;
+    arena_init(&ctx->arena, READ_BUFFER_SIZE);
+
+    struct sockaddr_storage peer;
+    int peer_len = sizeof(peer);
+    if (uv_tcp_getpeername(client, (struct sockaddr*)&peer, &peer_len) == 0 &&
+        peer.ss_family == AF_INET) {
+        ctx->ip = ((struct sockaddr_in*)&peer)->sin_addr.s_addr;
+    }
+
+    ctx->keep_alive = true;
+
+    // O(1) retrieval: the context rides on the handle itself. The
+    // registry is only for iteration; no locking since only this
+    // worker's loop thread touches it.
+    client->data = ctx;
+    client_table_insert(&worker->clients, ctx);
+
+    uv_read_start((uv_stream_t*)client, alloc_buffer, on_read);
+    // The first request's headers must arrive within the deadline
+    timer_wheel_schedule(ctx, reavix_state.header_timeout_ms);
+    return true;
+}
+
+static void on_connection(uv_stream_t* server, int status) {
+    if (status < 0) {
+        reavix_log(LOG_ERROR, NULL, "Connection error: %s", uv_strerror(status));
+        return;
+    }
+
+    // Drain the whole accept queue per wakeup: accepting one connection
+    // per callback lets the backlog grow between loop iterations during
+    // a reconnect stampede, which stalls established clients behind the
+    // queue. uv_accept() returns an error once the queue is empty.
+    ReavixWorker* worker = server->data;
+    while (client_adopt(worker, server)) {
+    }
+}
+
+static void alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+    (void)suggested_size;
+
+    ClientContext* ctx = handle->data;
+    ReavixWorker* worker = ctx ? ctx->worker : NULL;
+
+    ReadSlab* slab;
+    if (worker && worker->read_pool) {
+        slab = worker->read_pool;
+        worker->read_pool = slab->next;
+        worker->read_pool_count--;
+    } else {
+        slab = malloc(sizeof(ReadSlab));
+    }
+
+    buf->base = slab ? slab->data : NULL;
+    buf->len = slab ? READ_BUFFER_SIZE : 0;
+}
+
+static void read_buf_release(ReavixWorker* worker, char* base) {
+    if (!base) return;
+
+    ReadSlab* slab = (ReadSlab*)(base - offsetof(ReadSlab, data));
+    if (worker && worker->read_pool_count < READ_POOL_MAX) {
+        slab->next = worker->read_pool;
+        worker->read_pool = slab;
+        worker->read_pool_count++;
+    } else {
+        free(slab);
+    }
+}
+
+static void file_send_orphan(struct FileSend* fsend);
+
+static void on_client_close(uv_handle_t* handle) {
+    ClientSlot* slot = (ClientSlot*)handle;
+    ClientContext* ctx = handle->data;
+    ReavixWorker* worker = NULL;
+    if (ctx) {
+        worker = ctx->worker;
+        if (ctx->file_send) file_send_orphan(ctx->file_send);
+        timer_wheel_cancel(ctx);
+        ws_client_detach(ctx);
+        client_table_remove(&worker->clients, ctx->stream);
+        arena_destroy(&ctx->arena);
+        free(ctx->inbuf);
+    }
+    client_slot_release(worker, slot);
+}
+
+// IPC transport (PROTOCOL_IPC).
+//
+// Same-host callers reach the router over a Unix domain socket with
+// length-prefixed binary framing instead of loopback HTTP, skipping
+// the parser and header machinery entirely. One listener lives on
+// worker 0's loop. Frame layout (integers little-endian, payload_len
+// excluding its own four bytes):
+//
+//   request:  [u32 payload_len][u8 method_len][method]
+//             [u16 path_len][path][body...]
+//   response: [u32 payload_len][u16 status][body...]
+//
+// Accepted pipes run in ipc mode, so a peer can also pass an
+// established TCP descriptor across the socket; passed sockets are
+// adopted as regular HTTP clients on this worker.
+#define IPC_MAX_FRAME (MAX_HEADER_SIZE + MAX_BODY_SIZE)
+
+typedef struct {
+    uv_pipe_t handle;  // first member: handle and client coincide
+    ReavixWorker* worker;
+    char* inbuf;       // partial-frame accumulation across reads
+    size_t inbuf_len;
+    size_t inbuf_cap;
+    Arena arena;       // per-frame request/response scratch
+    char readbuf[READ_BUFFER_SIZE];
+} IpcClient;
+
+typedef struct {
+    uv_write_t req;
+    char* buf;
+} IpcWrite;
+
+static void on_ipc_close(uv_handle_t* handle) {
+    IpcClient* client = (IpcClient*)handle;
+    arena_destroy(&client->arena);
+    free(client->inbuf);
+    free(client);
+}
+
+static void on_ipc_write(uv_write_t* req, int status) {
+    IpcWrite* w = (IpcWrite*)req;
+    if (status < 0) {
+        reavix_log(LOG_DEBUG, NULL, "IPC write error: %s", uv_strerror(status));
+    }
+    free(w->buf);
+    free(w);
+}
+
+static void ipc_write_response(IpcClient* client, const Response* res) {
+    size_t body_len = res->content ? res->content_length : 0;
+    uint32_t payload = (uint32_t)(2 + body_len);
+
+    IpcWrite* w = malloc(sizeof(IpcWrite));
+    if (!w) return;
+    w->buf = malloc(4 + (size_t)payload);
+    if (!w->buf) {
+        free(w);
+        return;
+    }
+
+    w->buf[0] = (char)(payload & 0xFF);
+    w->buf[1] = (char)((payload >> 8) & 0xFF);
+    w->buf[2] = (char)((payload >> 16) & 0xFF);
+    w->buf[3] = (char)((payload >> 24) & 0xFF);
+    w->buf[4] = (char)(res->status_code & 0xFF);
+    w->buf[5] = (char)((res->status_code >> 8) & 0xFF);
+    if (body_len > 0) memcpy(w->buf + 6, res->content, body_len);
+
+    uv_buf_t buf = uv_buf_init(w->buf, 4 + payload);
+    if (uv_write(&w->req, (uv_stream_t*)&client->handle, &buf, 1, on_ipc_write) != 0) {
+        free(w->buf);
+        free(w);
+    }
+}
+
+// Decode one frame and run it through the shared dispatch path. The
+// pipe is never in the worker's client table, so the HTTP send helpers
+// quietly no-op; the status and body the handler left behind are
+// lifted into a response frame here instead.
+static void ipc_dispatch(IpcClient* client, const char* frame, size_t len) {
+    Response res;
+    memset(&res, 0, sizeof(res));
+    res.status_code = 200;
+    res.protocol = PROTOCOL_IPC;
+    res._internal.client = (uv_stream_t*)&client->handle;
+    res._internal.arena = &client->arena;
+
+    size_t method_len = len > 0 ? (uint8_t)frame[0] : 0;
+    if (len < 3 || 1 + method_len + 2 > len) {
+        res.status_code = 400;
+        ipc_write_response(client, &res);
+        return;
+    }
+    size_t path_len = (uint8_t)frame[1 + method_len] |
+                      ((size_t)(uint8_t)frame[2 + method_len] << 8);
+    size_t body_off = 1 + method_len + 2 + path_len;
+    if (body_off > len) {
+        res.status_code = 400;
+        ipc_write_response(client, &res);
+        return;
+    }
+
+    Request req;
+    memset(&req, 0, sizeof(req));
+    req.method = arena_strndup(&client->arena, frame + 1, method_len);
+    req.path = arena_strndup(&client->arena, frame + 3 + method_len, path_len);
+    req.body = frame + body_off;  // stable for the synchronous dispatch
+    req.body_length = len - body_off;
+    req.protocol = PROTOCOL_IPC;
+    req._internal.arena = &client->arena;
+    if (!req.method || !req.path) {
+        res.status_code = 500;
+        ipc_write_response(client, &res);
+        arena_reset(&client->arena);
+        return;
+    }
+
+    handle_request(&req, &res);
+    ipc_write_response(client, &res);
+    arena_reset(&client->arena);
+}
+
+static void ipc_alloc_buffer(uv_handle_t* handle, size_t suggested_size, uv_buf_t* buf) {
+    (void)suggested_size;
+    IpcClient* client = (IpcClient*)handle;
+    buf->base = client->readbuf;
+    buf->len = READ_BUFFER_SIZE;
+}
+
+static void on_ipc_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    IpcClient* client = (IpcClient*)stream;
+    (void)buf;
+
+    // Descriptor passing: adopt any TCP socket the peer sent along
+    while (uv_pipe_pending_count(&client->handle) > 0) {
+        if (uv_pipe_pending_type(&client->handle) != UV_TCP ||
+            !client_adopt(client->worker, stream)) {
+            // An unadoptable handle would wedge the pipe; drop the peer
+            uv_close((uv_handle_t*)stream, on_ipc_close);
+            return;
+        }
+    }
+
+    if (nread < 0) {
+        uv_close((uv_handle_t*)stream, on_ipc_close);
+        return;
+    }
+    if (nread == 0) return;
+
+    if (client->inbuf_len + (size_t)nread > client->inbuf_cap) {
+        size_t new_cap = client->inbuf_cap ? client->inbuf_cap * 2 : READ_BUFFER_SIZE;
+        while (new_cap < client->inbuf_len + (size_t)nread) new_cap *= 2;
+        if (new_cap > IPC_MAX_FRAME + 4) new_cap = IPC_MAX_FRAME + 4;
+        char* grown = new_cap >= client->inbuf_len + (size_t)nread
+                          ? realloc(client->inbuf, new_cap)
+                          : NULL;
+        if (!grown) {
+            uv_close((uv_handle_t*)stream, on_ipc_close);
+            return;
+        }
+        client->inbuf = grown;
+        client->inbuf_cap = new_cap;
+    }
+    memcpy(client->inbuf + client->inbuf_len, client->readbuf, (size_t)nread);
+    client->inbuf_len += (size_t)nread;
+
+    size_t consumed = 0;
+    while (client->inbuf_len - consumed >= 4) {
+        const uint8_t* p = (const uint8_t*)client->inbuf + consumed;
+        uint32_t payload = (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        if (payload > IPC_MAX_FRAME) {
+            uv_close((uv_handle_t*)stream, on_ipc_close);
+            return;
+        }
+        if (client->inbuf_len - consumed < 4 + (size_t)payload) break;
+        ipc_dispatch(client, client->inbuf + consumed + 4, payload);
+        consumed += 4 + (size_t)payload;
+    }
+    if (consumed > 0) {
+        client->inbuf_len -= consumed;
+        memmove(client->inbuf, client->inbuf + consumed, client->inbuf_len);
+    }
+}
+
+static void on_ipc_connection(uv_stream_t* server, int status) {
+    if (status < 0) {
+        reavix_log(LOG_ERROR, NULL, "IPC connection error: %s", uv_strerror(status));
+        return;
+    }
+    ReavixWorker* worker = server->data;
+
+    for (;;) {
+        IpcClient* client = calloc(1, sizeof(IpcClient));
+        if (!client) return;
+
+        // ipc mode so passed descriptors arrive as pending handles
+        uv_pipe_init(&worker->loop, &client->handle, 1);
+        if (uv_accept(server, (uv_stream_t*)&client->handle) != 0) {
+            uv_close((uv_handle_t*)&client->handle, on_ipc_close);
+            return;
+        }
+        client->worker = worker;
+        arena_init(&client->arena, READ_BUFFER_SIZE);
+        uv_read_start((uv_stream_t*)&client->handle, ipc_alloc_buffer, on_ipc_read);
+    }
+}
+
+static bool ipc_bind_listener(ReavixWorker* worker) {
+    if (uv_pipe_init(&worker->loop, &worker->ipc_server, 0) != 0) return false;
+    worker->ipc_server.data = worker;
+
+    unlink(reavix_state.ipc_path);  // stale socket from a previous run
+    if (uv_pipe_bind(&worker->ipc_server, reavix_state.ipc_path) != 0) return false;
+
+    int backlog = reavix_state.listen_backlog > 0 ? reavix_state.listen_backlog
+                                                  : SOMAXCONN;
+    return uv_listen((uv_stream_t*)&worker->ipc_server, backlog,
+                     on_ipc_connection) == 0;
+}
+
+// HTTP/1.1 request parsing. The vectorized parser tokenizes the header
+// block into views in one pass; the pieces the Request keeps are then
+// copied into the connection's arena since the read slab is recycled.
+// The body is delimited by Content-Length, already validated by the
+// connection state machine.
+static Request* parse_http_request(Arena* arena, const char* data, size_t header_len,
+                                   const char* body, size_t body_len) {
+    ParsedRequest parsed;
+    if (parser_parse_request(data, header_len, &parsed) <= 0) return NULL;
+
+    Request* req = arena_alloc(arena, sizeof(Request));
+    if (!req) return NULL;
+    memset(req, 0, sizeof(Request));
+    req->_internal.arena = arena;
+
+    // Split an optional query string off the target
+    const char* query = memchr(parsed.target, '?', parsed.target_len);
+    if (query) {
+        req->path = arena_strndup(arena, parsed.target, (size_t)(query - parsed.target));
+        req->query = arena_strndup(arena, query + 1,
+            parsed.target_len - (size_t)(query + 1 - parsed.target));
+    } else {
+        req->path = arena_strndup(arena, parsed.target, parsed.target_len);
+    }
+    req->method = arena_strndup(arena, parsed.method, parsed.method_len);
+    req->protocol = PROTOCOL_HTTP;
+
+    if (parsed.header_count > 0) {
+        req->_internal.header_names =
+            arena_alloc(arena, parsed.header_count * sizeof(char*));
+        req->_internal.header_values =
+            arena_alloc(arena, parsed.header_count * sizeof(char*));
+        if (!req->_internal.header_names || !req->_internal.header_values) return NULL;
+
+        for (size_t i = 0; i < parsed.header_count; i++) {
+            req->_internal.header_names[i] =
+                arena_strndup(arena, parsed.headers[i].name, parsed.headers[i].name_len);
+            req->_internal.header_values[i] =
+                arena_strndup(arena, parsed.headers[i].value, parsed.headers[i].value_len);
+        }
+        req->_internal.header_count = parsed.header_count;
+    }
+
+    if (body_len > 0) {
+        req->body = arena_strndup(arena, body, body_len);
+        req->body_length = body_len;
+    }
+
+    return req;
+}
+
+// ---- Connection state machine ----
+//
+// A connection accumulates bytes until a complete request (terminated
+// headers plus Content-Length body) is available, dispatches it, and
+// repeats — so multiple sequential and pipelined requests on one socket
+/// are answered in order. Connection: keep-alive/close and the HTTP/1.0
+// default are honored; close flushes pending writes via shutdown.
+
+static size_t scan_content_length(const char* headers, size_t len) {
+    const char* p = headers;
+    const char* end = headers + len;
+    while (p < end) {
+        const char* eol = memchr(p, '\n', (size_t)(end - p));
+        if (!eol) break;
+        if ((size_t)(eol - p) > 15 && strncasecmp(p, "Content-Length:", 15) == 0) {
+            return (size_t)strtoul(p + 15, NULL, 10);
+        }
+        p = eol + 1;
+    }
+    return 0;
+}
+
+static bool scan_keep_alive(const char* headers, size_t len) {
+    const char* end = headers + len;
+    const char* eol = memchr(headers, '\n', len);
+
+    // Version default: HTTP/1.1 keeps alive, HTTP/1.0 closes
+    bool keep = true;
+    if (eol) {
+        size_t line_len = (size_t)(eol - headers);
+        if (line_len > 0 && headers[line_len - 1] == '\r') line_len--;
+        if (line_len >= 8 && strncmp(headers + line_len - 8, "HTTP/1.0", 8) == 0) {
+            keep = false;
+        }
+    }
+
+    const char* p = eol ? eol + 1 : end;
+    while (p < end) {
+        const char* e = memchr(p, '\n', (size_t)(end - p));
+        if (!e) break;
+        if ((size_t)(e - p) > 11 && strncasecmp(p, "Connection:", 11) == 0) {
+            const char* value = p + 11;
+            while (value < e && *value == ' ') value++;
+            if (strncasecmp(value, "close", 5) == 0) return false;
+            if (strncasecmp(value, "keep-alive", 10) == 0) return true;
+        }
+        p = e + 1;
+    }
+    return keep;
+}
+
+static void on_shutdown(uv_shutdown_t* sreq, int status) {
+    (void)status;
+    uv_close((uv_handle_t*)sreq->handle, on_client_close);
+    free(sreq);
+}
+
+// Close after flushing queued responses
+static void connection_shutdown(ClientContext* ctx) {
+    uv_read_stop(ctx->stream);
+    if (ctx->file_send) {
+        // A sendfile stream bypasses uv's write queue; shutting down now
+        // would cut the body short. Finish the file first.
+        ctx->close_after_send = true;
+        return;
+    }
+    uv_shutdown_t* sreq = malloc(sizeof(uv_shutdown_t));
+    if (sreq && uv_shutdown(sreq, ctx->stream, on_shutdown) == 0) return;
+    free(sreq);
+    uv_close((uv_handle_t*)ctx->stream, on_client_close);
+}
+
+// Answer a request that can never be dispatched (e.g. a buffered body
+// over MAX_BODY_SIZE) with a canned response, then flush and close.
+// The shutdown waits on uv's write queue, so the status reaches the
+// client instead of a bare connection drop.
+static void connection_reject(ClientContext* ctx, const char* response) {
+    size_t len = strlen(response);
+    WriteReq* wr = len <= WRITE_INLINE_SIZE ? write_req_acquire(ctx->worker) : NULL;
+    if (wr) {
+        memcpy(wr->inline_buf, response, len);
+        uv_buf_t buf = uv_buf_init(wr->inline_buf, (unsigned)len);
+        if (uv_write(&wr->req, ctx->stream, &buf, 1, on_pooled_write) != 0) {
+            write_req_release(wr);
+        }
+    }
+    connection_shutdown(ctx);
+}
+
+// Hand a freshly upgraded connection to its matched route handler so
+// application code can greet the peer (reavix_ws_send) or subscribe it
+// to topics. The 101 is already on the wire, so the HTTP send machinery
+// is disarmed by marking headers_sent before the handler runs; res and
+// req are arena-backed and valid only for the duration of the call —
+// pushes after it go through the subscription machinery. Only sync
+// handlers apply: deferred completion has no meaning on a socket that
+// no longer speaks HTTP.
+static void ws_dispatch_upgrade(Request* req, Response* res) {
+    PathParam path_params[MAX_PARAMS];
+    size_t path_param_count = 0;
+    RouteHandler route_handler = NULL;
+    uint8_t handler_mode = ROUTE_MODE_SYNC;
+
+    SealedRouter* sealed = atomic_load_explicit(&reavix_state.sealed, memory_order_acquire);
+    if (sealed) {
+        SealedNode* matched_node = NULL;
+        if (!sealed_match(sealed, req->path, path_params, &path_param_count,
+                          &route_handler, &matched_node)) {
+            return;
+        }
+        if (matched_node) handler_mode = matched_node->handler_mode;
+    } else {
+        TrieNode* root = atomic_load_explicit(&reavix_state.live_root, memory_order_acquire);
+        if (!root || !trie_match(root, req->path, path_params, &path_param_count,
+                                 &route_handler, &handler_mode)) {
+            return;
+        }
+    }
+    if (!route_handler || handler_mode != ROUTE_MODE_SYNC) return;
+
+    req->_internal.params = path_params;
+    req->_internal.param_count = path_param_count;
+    res->_internal.headers_sent = true;
+    route_handler(req, res);
+    req->_internal.params = NULL;
+    req->_internal.param_count = 0;
+}
+
+static void dispatch_request(ClientContext* ctx, const char* data,
+                             size_t header_len, size_t body_len) {
+    Request* req = parse_http_request(&ctx->arena, data, header_len,
+                                      data + header_len, body_len);
+
+    Response* res = arena_alloc(&ctx->arena, sizeof(Response));
+    if (!res) {
+        ctx->keep_alive = false;
+        arena_reset(&ctx->arena);
+        return;
+    }
+    memset(res, 0, sizeof(Response));
+    res->status_code = 200;
+    res->protocol = PROTOCOL_HTTP;
+    res->_internal.client = ctx->stream;
+    res->_internal.arena = &ctx->arena;
+
+    RequestMetrics* metrics = arena_alloc(&ctx->arena, sizeof(RequestMetrics));
+    if (metrics) {
+        memset(metrics, 0, sizeof(*metrics));
+        // Coarse cached timestamp (1s resolution); latency measurement
+        // uses uv_hrtime separately, so no syscall per request here
+        metrics->start_time = ctx->worker->wall_coarse;
+        res->_internal.metrics = metrics;
+        if (req) req->_internal.metrics = metrics;
+    }
+
+    if (!req) {
+        res_send_error(res, 400, "Bad Request");
+        ctx->keep_alive = false;
+    } else if (try_websocket_upgrade(ctx, req)) {
+        ctx->keep_alive = true;  // the socket now belongs to WebSocket
+        ws_dispatch_upgrade(req, res);
+    } else {
+        if (!ctx->keep_alive) {
+            res_set_header(res, "Connection", "close");
+        }
+        ctx->current_req = req;
+        handle_request(req, res);
+        ctx->current_req = NULL;
+
+        if (ctx->body_stream) {
+            // A streaming-body handler owns the request; the arena
+            // stays alive until the last body byte is delivered
+            return;
+        }
+        if (res->_internal.async && !res->_internal.async_done) {
+            // An async handler owns the request now: keep the arena
+            // alive and pause reads until res_complete()
+            ctx->async_pending = true;
+            uv_read_stop(ctx->stream);
+            return;
+        }
+    }
+
+    // Everything the request/response touched lives in the arena; one
+    // reset recycles it all for the next request on this connection.
+    arena_reset(&ctx->arena);
+}
+
+// Streaming request bodies. A route registered with
+// reavix_route_stream() dispatches as soon as its header block is
+// complete; the body is never buffered and bypasses MAX_BODY_SIZE.
+// Incoming bytes are handed to the handler's chunk callback straight
+// from the read slab; a false return stops reads until
+// req_stream_resume(), with anything already in flight accumulating in
+// inbuf up to the configurable watermark.
+typedef struct BodyStream {
+    const Request* req;
+    Response* res;
+    BodyChunkHandler on_chunk;
+    BodyDoneHandler on_done;
+    void* user;
+    size_t remaining;  // body bytes the client still owes
+    bool paused;
+} BodyStream;
+
+// Decide from the raw header block whether the target route streams its
+// body: one request-line parse plus a route match, paid only for
+// requests that carry a body while stream routes exist.
+static bool route_wants_stream(const char* data, size_t header_len) {
+    ParsedRequest parsed;
+    if (parser_parse_request(data, header_len, &parsed) <= 0) return false;
+
+    const char* query = memchr(parsed.target, '?', parsed.target_len);
+    size_t path_len = query ? (size_t)(query - parsed.target) : parsed.target_len;
+    char path[1024];
+    if (path_len == 0 || path_len >= sizeof(path)) return false;
+    memcpy(path, parsed.target, path_len);
+    path[path_len] = '\0';
+
+    PathParam params[MAX_PARAMS];
+    size_t param_count = 0;
+    RouteHandler handler = NULL;
+    uint8_t mode = ROUTE_MODE_SYNC;
+
+    SealedRouter* sealed = atomic_load_explicit(&reavix_state.sealed, memory_order_acquire);
+    if (sealed) {
+        SealedNode* node = NULL;
+        if (sealed_match(sealed, path, params, &param_count, &handler, &node) && node) {
+            mode = node->handler_mode;
+        }
+    } else {
+        TrieNode* root = atomic_load_explicit(&reavix_state.live_root, memory_order_acquire);
+        if (!root || !trie_match(root, path, params, &param_count, &handler, &mode)) {
+            return false;
+        }
+    }
+    return handler && mode == ROUTE_MODE_STREAM;
+}
+
+// Complete a body stream: fire on_done, flush the response, and recycle
+// the request state. Returns false if the connection was handed off to
+// shutdown.
+static bool body_stream_finish(ClientContext* ctx) {
+    BodyStream* bs = ctx->body_stream;
+    ctx->body_stream = NULL;
+
+    if (bs->on_done) bs->on_done(bs->req, bs->res, bs->user);
+    if (!bs->res->_internal.headers_sent) send_response(bs->res);
+    arena_reset(&ctx->arena);
+
+    if (!ctx->keep_alive) {
+        connection_shutdown(ctx);
+        return false;
+    }
+    return true;
+}
+
+// Feed incoming bytes to the active stream. Returns bytes consumed, or
+// -1 if the connection was handed off to shutdown/close.
+static ssize_t body_stream_feed(ClientContext* ctx, const char* data, size_t len) {
+    BodyStream* bs = ctx->body_stream;
+    if (bs->paused) return 0;
+
+    size_t take = len < bs->remaining ? len : bs->remaining;
+    if (take > 0 && bs->on_chunk &&
+        !bs->on_chunk(bs->req, bs->res, data, take, bs->user)) {
+        bs->paused = true;
+        uv_read_stop(ctx->stream);
+    }
+    bs->remaining -= take;
+
+    if (bs->remaining == 0 && !body_stream_finish(ctx)) return -1;
+    return (ssize_t)take;
+}
+
+void req_stream_body(const Request* req, Response* res,
+                     BodyChunkHandler on_chunk, BodyDoneHandler on_done, void* user) {
+    if (!req || !res) return;
+
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx || ctx->body_stream || !res->_internal.arena) return;
+
+    BodyStream* bs = arena_alloc(res->_internal.arena, sizeof(BodyStream));
+    if (!bs) return;
+    memset(bs, 0, sizeof(*bs));
+    bs->req = req;
+    bs->res = res;
+    bs->on_chunk = on_chunk;
+    bs->on_done = on_done;
+    bs->user = user;
+    ctx->body_stream = bs;
+}
+
+void reavix_set_stream_watermark(size_t max_buffered_bytes) {
+    if (max_buffered_bytes) reavix_state.stream_watermark = max_buffered_bytes;
+}
+
+// Drain complete requests from data. Returns bytes consumed, or -1 if
+// the connection was handed off to shutdown/close.
+static ssize_t connection_process(ClientContext* ctx, const char* data, size_t len) {
+    size_t consumed = 0;
+
+    // Upgraded connections no longer speak HTTP; incoming frames are
+    // swallowed (close is detected via EOF)
+    if (ctx->is_websocket) return (ssize_t)len;
+
+    // An in-flight body stream consumes raw bytes before HTTP framing
+    if (ctx->body_stream) {
+        ssize_t fed = body_stream_feed(ctx, data, len);
+        if (fed < 0) return -1;
+        consumed += (size_t)fed;
+        if (ctx->body_stream) {
+            if (ctx->body_stream->paused &&
+                len - consumed > reavix_state.stream_watermark) {
+                uv_close((uv_handle_t*)ctx->stream, on_client_close);
+                return -1;
+            }
+            return (ssize_t)consumed;  // mid-body, or paused
+        }
+    }
+
+    while (consumed < len) {
+        const char* start = data + consumed;
+        size_t avail = len - consumed;
+
+        size_t header_len = parser_find_headers_end(start, avail);
+        if (header_len == 0) {
+            if (avail > MAX_HEADER_SIZE) {
+                uv_close((uv_handle_t*)ctx->stream, on_client_close);
+                return -1;
+            }
+            break;  // need more data
+        }
+
+        size_t body_len = scan_content_length(start, header_len);
+        bool streaming = body_len > 0 && reavix_state.have_stream_routes &&
+                         route_wants_stream(start, header_len);
+        if (!streaming) {
+            if (body_len > MAX_BODY_SIZE) {
+                // No streaming route claimed it and it cannot be
+                // buffered: say why instead of dropping the connection
+                connection_reject(ctx,
+                    "HTTP/1.1 413 Content Too Large\r\n"
+                    "Content-Length: 0\r\n"
+                    "Connection: close\r\n\r\n");
+                return -1;
+            }
+            if (avail < header_len + body_len) {
+                break;  // need the rest of the body
+            }
+        }
+
+        ctx->keep_alive = scan_keep_alive(start, header_len);
+
+        if (streaming) {
+            // Dispatch on headers alone; the handler registers its body
+            // callbacks before this returns
+            dispatch_request(ctx, start, header_len, 0);
+            consumed += header_len;
+            if (!ctx->body_stream) {
+                // The handler declined to stream; the body cannot be
+                // replayed, so the connection can't continue
+                connection_shutdown(ctx);
+                return -1;
+            }
+            ctx->body_stream->remaining = body_len;
+            ((Request*)ctx->body_stream->req)->body_length = body_len;
+
+            ssize_t fed = body_stream_feed(ctx, data + consumed, len - consumed);
+            if (fed < 0) return -1;
+            consumed += (size_t)fed;
+            if (ctx->body_stream) return (ssize_t)consumed;  // mid-body
+            continue;
+        }
+
+        dispatch_request(ctx, start, header_len, body_len);
+        consumed += header_len + body_len;
+
+        if (ctx->body_stream) {
+            // Stream route with no body: nothing to feed, complete now
+            if (!body_stream_finish(ctx)) return -1;
+        }
+        if (!ctx->keep_alive) {
+            connection_shutdown(ctx);
+            return -1;
+        }
+        if (ctx->file_send || ctx->async_pending) {
+            // A sendfile stream or async handler owns the socket;
+            // pipelined requests stay buffered until it completes.
+            break;
+        }
+    }
+    return (ssize_t)consumed;
+}
+
+static bool connection_buffer_append(ClientContext* ctx, const char* data, size_t len) {
+    if (ctx->inbuf_len + len > ctx->inbuf_cap) {
+        size_t cap = ctx->inbuf_cap ? ctx->inbuf_cap : READ_BUFFER_SIZE;
+        while (cap < ctx->inbuf_len + len) cap *= 2;
+        char* grown = realloc(ctx->inbuf, cap);
+        if (!grown) return false;
+        ctx->inbuf = grown;
+        ctx->inbuf_cap = cap;
+    }
+    memcpy(ctx->inbuf + ctx->inbuf_len, data, len);
+    ctx->inbuf_len += len;
+    return true;
+}
+
+static void on_read(uv_stream_t* stream, ssize_t nread, const uv_buf_t* buf) {
+    ClientContext* ctx = find_client_context(stream);
+    ReavixWorker* worker = ctx ? ctx->worker : NULL;
+
+    if (nread <= 0) {
+        if (nread != UV_EOF && nread < 0) {
+            reavix_log(LOG_DEBUG, NULL, "Read error: %s", uv_strerror((int)nread));
+        }
+        read_buf_release(worker, buf->base);
+        if (nread < 0) {
+            uv_close((uv_handle_t*)stream, on_client_close);
+        }
+        return;
+    }
+
+    if (!ctx) {
+        read_buf_release(worker, buf->base);
+        uv_close((uv_handle_t*)stream, on_client_close);
+        return;
+    }
+
+    if (ctx->inbuf_len == 0) {
+        // Fast path: parse straight out of the read slab; only bytes of
+        // an incomplete trailing request are copied into the buffer
+        ssize_t consumed = connection_process(ctx, buf->base, (size_t)nread);
+        if (consumed < 0) {
+            read_buf_release(worker, buf->base);
+            return;
+        }
+        if ((size_t)consumed < (size_t)nread &&
+            !connection_buffer_append(ctx, buf->base + consumed,
+                                      (size_t)nread - (size_t)consumed)) {
+            read_buf_release(worker, buf->base);
+            uv_close((uv_handle_t*)stream, on_client_close);
+            return;
+        }
+    } else {
+        if (!connection_buffer_append(ctx, buf->base, (size_t)nread)) {
+            read_buf_release(worker, buf->base);
+            uv_close((uv_handle_t*)stream, on_client_close);
+            return;
+        }
+        ssize_t consumed = connection_process(ctx, ctx->inbuf, ctx->inbuf_len);
+        if (consumed < 0) {
+            read_buf_release(worker, buf->base);
+            return;
+        }
+        if (consumed > 0) {
+            ctx->inbuf_len -= (size_t)consumed;
+            memmove(ctx->inbuf, ctx->inbuf + consumed, ctx->inbuf_len);
+        }
+    }
+
+    connection_arm_deadline(ctx);
+    read_buf_release(worker, buf->base);
+}
+
+// Request handling.
+//
+// Middleware runs off the compiled chain. The cursor lives on the
+// dispatching stack frame and next() reaches it through a thread-local,
+// so advancing the chain is an index increment plus an indirect call
+// with no allocation and no re-walk of the registration arrays. A
+// middleware that returns without calling next() — or that sends the
+// response — short-circuits the rest of the chain and the route
+// handler, exactly as its signature has always promised.
+typedef struct {
+    const MiddlewareChain* chain;
+    size_t index;
+    bool ran_to_end;
+} MiddlewareCursor;
+
+static _Thread_local MiddlewareCursor* mw_cursor;
+
+static void middleware_next(Request* req, Response* res) {
+    MiddlewareCursor* cur = mw_cursor;
+    if (!cur) return;
+
+    while (cur->index < cur->chain->count) {
+        if (res->_internal.headers_sent) return;
+        const MiddlewareStep* step = &cur->chain->steps[cur->index++];
+        if (step->mw) {
+            // The middleware drives the remainder via its own next()
+            step->mw(req, res, middleware_next);
+            return;
+        }
+        // Plugin pre-handlers take no next(): run and fall through
+        step->hook(req, res);
+    }
+    cur->ran_to_end = true;
+}
+
+static void handle_request(Request* req, Response* res) {
+    uint64_t metrics_t0 = uv_hrtime();
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    ReavixWorker* worker = ctx ? ctx->worker : NULL;
+
+    // Middleware and plugin pre-handlers, off the compiled chain
+    MiddlewareChain* chain = atomic_load_explicit(&reavix_state.mw_chain,
+                                                  memory_order_acquire);
+    if (chain) {
+        MiddlewareCursor cursor = { .chain = chain, .index = 0, .ran_to_end = false };
+        MiddlewareCursor* prev = mw_cursor;
+        mw_cursor = &cursor;
+        middleware_next(req, res);
+        mw_cursor = prev;
+        if (!cursor.ran_to_end || res->_internal.headers_sent) {
+            return;
+        }
+    }
+
+    // Route handling
+    PathParam path_params[MAX_PARAMS];
+    size_t path_param_count = 0;
+    RouteHandler route_handler = NULL;
+
+    // Lock-free matching: prefer the sealed dispatch table, fall back to
+    // the published trie snapshot before the router is sealed.
+    bool is_matched;
+    uint8_t handler_mode = ROUTE_MODE_SYNC;
+    SealedNode* matched_node = NULL;
+    SealedRouter* sealed = atomic_load_explicit(&reavix_state.sealed, memory_order_acquire);
+    if (sealed) {
+        is_matched = sealed_match(sealed, req->path,
+                                  path_params, &path_param_count, &route_handler,
+                                  &matched_node);
+        if (matched_node) handler_mode = matched_node->handler_mode;
+    } else {
+        TrieNode* root = atomic_load_explicit(&reavix_state.live_root, memory_order_acquire);
+        is_matched = root && trie_match(root, req->path,
+                                    path_params, &path_param_count, &route_handler,
+                                    &handler_mode);
+    }
+
+    // Rate limiting: buckets live in the sealed route nodes, so limits
+    // are enforced once the router is sealed
+    if (is_matched && matched_node && matched_node->rate_limit.enabled) {
+        uint64_t now_ms = worker ? uv_now(&worker->loop) : 0;
+        if (!check_rate_limit(matched_node, ctx ? ctx->ip : 0, now_ms)) {
+            res_send_error(res, 429, "Too Many Requests");
+            return;
+        }
+    }
+
+    if (is_matched && route_handler) {
+        req->_internal.params = path_params;
+        req->_internal.param_count = path_param_count;
+
+        if (res->protocol == PROTOCOL_IPC && handler_mode != ROUTE_MODE_SYNC) {
+            // IPC frames are answered as soon as dispatch returns, and
+            // a pipe has no connection context for deferred completion
+            res_send_error(res, 501, "Not Implemented");
+            req->_internal.params = NULL;
+            req->_internal.param_count = 0;
+        } else if (handler_mode == ROUTE_MODE_SYNC) {
+            // Params are views into req->path; a sync handler runs to
+            // completion before this frame unwinds, so the stack array
+            // outlives it.
+            route_handler(req, res);
+            req->_internal.params = NULL;
+            req->_internal.param_count = 0;
+        } else {
+            // The request outlives this frame: move the param views
+            // into the arena (values keep pointing into req->path)
+            Arena* arena = res->_internal.arena;
+            if (path_param_count > 0 && arena) {
+                PathParam* copy = arena_alloc(arena, path_param_count * sizeof(PathParam));
+                if (copy) {
+                    memcpy(copy, path_params, path_param_count * sizeof(PathParam));
+                    req->_internal.params = copy;
+                } else {
+                    req->_internal.params = NULL;
+                    req->_internal.param_count = 0;
+                }
+            }
+            if (handler_mode == ROUTE_MODE_STREAM) {
+                // Streaming handler: runs at headers-complete and
+                // registers body callbacks via req_stream_body(); the
+                // connection machinery drives completion
+                route_handler(req, res);
+            } else if (handler_mode == ROUTE_MODE_WORK && worker) {
+                res->_internal.async = true;
+                if (!handler_offload(worker, req, res, route_handler)) {
+                    res->_internal.async = false;
+                    res_send_error(res, 503, "Service Unavailable");
+                }
+            } else {
+                // Async handler: runs now, completes via res_complete()
+                res->_internal.async = true;
+                route_handler(req, res);
+            }
+        }
+    } else if (strcmp(req->path, "/metrics") == 0) {
+        metrics_render(res);
+    } else {
+        res_send_error(res, 404, "Not Found");
+    }
+
+    uint64_t elapsed_us = (uv_hrtime() - metrics_t0) / 1000;
+    metrics_record(worker, sealed, is_matched ? matched_node : NULL,
+                   elapsed_us, res->content_length);
+    RequestMetrics* rm = res->_internal.metrics;
+    if (rm) {
+        rm->requests_handled = worker ? worker->requests_handled : 0;
+        rm->bytes_sent = res->content_length;
+    }
+
+    // Apply post-handler plugins
+    for (size_t i = 0; i < reavix_state.plugin_count; i++) {
+        if (reavix_state.plugins[i].post_handler) {
+            reavix_state.plugins[i].post_handler(req, res);
+        }
+    }
+}
+
+// Response allocation helpers: prefer the owning arena, fall back to
+// the heap for responses created outside a connection lifecycle.
+static void* res_alloc(Response* res, size_t size) {
+    return res->_internal.arena ? arena_alloc(res->_internal.arena, size) : malloc(size);
+}
+
+static char* res_strdup(Response* res, const char* s) {
+    return res->_internal.arena ? arena_strdup(res->_internal.arena, s) : strdup(s);
+}
+
+static void res_release(Response* res, void* ptr) {
+    if (!res->_internal.arena) free(ptr);
+}
+
+// Response implementation
+void res_send_json(Response* res, const char* json) {
+    if (!res || !json) return;
+
+    res_release(res, res->content);
+    res->content = res_strdup(res, json);
+    res->content_length = strlen(json);
+    res_set_header(res, "Content-Type", "application/json");
+
+    CompressionType type = resolve_compression(res->_internal.compression);
+    if (type != COMPRESSION_NONE &&
+        res->content_length >= reavix_state.compression_threshold) {
+        // Large bodies compress and transmit in chunked pipeline
+        if (res->content_length >= COMPRESS_STREAM_THRESHOLD &&
+            type != COMPRESSION_BROTLI) {
+            send_response_compressed_chunked(res, type);
+            if (res->_internal.headers_sent) return;
+        }
+
+        ClientContext* ctx = find_client_context(res->_internal.client);
+        char* compressed;
+        size_t compressed_len;
+        if (compress_data(ctx ? ctx->worker : NULL, res->_internal.arena,
+                          res->content, res->content_length,
+                          &compressed, &compressed_len, type)) {
+            res_release(res, res->content);
+            res->content = compressed;
+            res->content_length = compressed_len;
+            res_set_header(res, "Content-Encoding", compression_encoding_name(type));
+        }
+    }
+
+    send_response(res);
+}
+
+// Open-file cache: per-worker LRU of served files holding the open fd,
+// its stat, the mmap'd contents for small files, and lazily built
+// precompressed variants, so hot static assets skip the per-request
+// open/fstat/compress work. ETag and Last-Modified are rendered once
+// from the cached stat. Entries revalidate against the path at most
+// once per second and are dropped when the file changed underneath or
+// the cache is full. Owned by the worker's loop thread, like its pools.
+#define FILE_CACHE_MAX 128
+#define FILE_CACHE_MMAP_MAX (256 * 1024)
+#define FILE_CACHE_REVALIDATE_MS 1000
+
+typedef struct FileCacheEntry {
+    char* path;
+    uint64_t path_hash;
+    int fd;
+    struct stat st;
+    uint64_t checked_ms;     // last revalidation, loop clock
+    char* map;               // NULL for files above FILE_CACHE_MMAP_MAX
+    // Precompressed variants of the mmap'd contents, indexed by
+    // CompressionType - 1 (gzip, brotli, deflate); built on first demand
+    char* variants[3];
+    size_t variant_lens[3];
+    bool variant_failed[3];
+    char etag[32];
+    char last_modified[40];
+    struct FileCacheEntry* prev;
+    struct FileCacheEntry* next;
+} FileCacheEntry;
+
+static uint64_t file_cache_hash(const char* s) {
+    uint64_t h = 0xcbf29ce484222325ULL;  // FNV-1a
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void file_cache_unlink(ReavixWorker* worker, FileCacheEntry* entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else worker->fc_head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else worker->fc_tail = entry->prev;
+    worker->fc_count--;
+}
+
+static void file_cache_push_front(ReavixWorker* worker, FileCacheEntry* entry) {
+    entry->prev = NULL;
+    entry->next = worker->fc_head;
+    if (worker->fc_head) worker->fc_head->prev = entry;
+    worker->fc_head = entry;
+    if (!worker->fc_tail) worker->fc_tail = entry;
+    worker->fc_count++;
+}
+
+static void file_cache_entry_free(FileCacheEntry* entry) {
+    if (entry->map) munmap(entry->map, (size_t)entry->st.st_size);
+    close(entry->fd);
+    for (int i = 0; i < 3; i++) free(entry->variants[i]);
+    free(entry->path);
+    free(entry);
+}
+
+static FileCacheEntry* file_cache_lookup(ReavixWorker* worker, const char* path,
+                                         uint64_t now_ms) {
+    uint64_t h = file_cache_hash(path);
+    for (FileCacheEntry* entry = worker->fc_head; entry; entry = entry->next) {
+        if (entry->path_hash != h || strcmp(entry->path, path) != 0) continue;
+
+        if (now_ms - entry->checked_ms >= FILE_CACHE_REVALIDATE_MS) {
+            // Stat the path, not the fd, so a replaced file (new inode)
+            // is noticed too
+            struct stat st;
+            if (stat(path, &st) != 0 || st.st_ino != entry->st.st_ino ||
+                st.st_mtime != entry->st.st_mtime || st.st_size != entry->st.st_size) {
+                file_cache_unlink(worker, entry);
+                file_cache_entry_free(entry);
+                return NULL;  // caller reloads from the filesystem
+            }
+            entry->checked_ms = now_ms;
+        }
+
+        if (entry != worker->fc_head) {
+            file_cache_unlink(worker, entry);
+            file_cache_push_front(worker, entry);
+        }
+        return entry;
+    }
+    return NULL;
+}
+
+// Takes ownership of fd (it is closed with the entry on eviction).
+static FileCacheEntry* file_cache_insert(ReavixWorker* worker, const char* path,
+                                         int fd, const struct stat* st, uint64_t now_ms) {
+    FileCacheEntry* entry = calloc(1, sizeof(FileCacheEntry));
+    if (!entry) return NULL;
+    entry->path = strdup(path);
+    if (!entry->path) {
+        free(entry);
+        return NULL;
+    }
+    entry->path_hash = file_cache_hash(path);
+    entry->fd = fd;
+    entry->st = *st;
+    entry->checked_ms = now_ms;
+
+    snprintf(entry->etag, sizeof(entry->etag), "\"%llx-%llx\"",
+        (unsigned long long)st->st_size, (unsigned long long)st->st_mtime);
+    struct tm tm;
+    gmtime_r(&st->st_mtime, &tm);
+    strftime(entry->last_modified, sizeof(entry->last_modified),
+        "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+    if (st->st_size > 0 && st->st_size <= FILE_CACHE_MMAP_MAX) {
+        void* map = mmap(NULL, (size_t)st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) entry->map = map;
+    }
+
+    if (worker->fc_count >= FILE_CACHE_MAX) {
+        FileCacheEntry* victim = worker->fc_tail;
+        file_cache_unlink(worker, victim);
+        file_cache_entry_free(victim);
+    }
+    file_cache_push_front(worker, entry);
+    return entry;
+}
+
+// Memoized precompressed variant of an mmap'd entry: compressed through
+// the worker's pooled stream on first demand, a pointer lookup after.
+static bool file_cache_variant(ReavixWorker* worker, FileCacheEntry* entry,
+                               CompressionType type, char** out, size_t* out_len) {
+    int slot = (int)type - 1;
+    if (!entry->map || slot < 0 || slot > 2 || entry->variant_failed[slot]) return false;
+
+    if (!entry->variants[slot]) {
+        if (!compress_data(worker, NULL, entry->map, (size_t)entry->st.st_size,
+                           &entry->variants[slot], &entry->variant_lens[slot], type) ||
+            entry->variant_lens[slot] >= (size_t)entry->st.st_size) {
+            // Not compressible (or failed): remember and serve raw
+            free(entry->variants[slot]);
+            entry->variants[slot] = NULL;
+            entry->variant_failed[slot] = true;
+            return false;
+        }
+    }
+    *out = entry->variants[slot];
+    *out_len = entry->variant_lens[slot];
+    return true;
+}
+
+// Zero-copy file responses. The body never enters userspace: after the
+// header block is flushed through uv's write queue, the file is pushed
+// straight from the page cache to the socket with uv_fs_sendfile() in
+// SENDFILE_CHUNK slices. The connection's reads stay paused for the
+// duration so keep-alive pipelining cannot interleave another response
+// with the out-of-band body bytes.
+#define SENDFILE_CHUNK (1 << 20)
+
+typedef struct FileSend {
+    uv_fs_t fs;
+    uv_write_t write;
+    ClientContext* ctx;     // NULL once the connection died under us
+    uv_os_fd_t sock_fd;
+    uv_file file_fd;
+    int64_t offset;
+    size_t remaining;
+    char headers[WRITE_INLINE_SIZE];
+} FileSend;
+
+static void file_send_next(FileSend* fsend);
+
+// The owning connection closed while a transfer was in flight; the next
+// callback cleans up without touching the dead context.
+static void file_send_orphan(FileSend* fsend) {
+    fsend->ctx = NULL;
+}
+
+// Process requests that arrived while a file send had the socket. May
+// itself start another file send or hand the connection to shutdown;
+// returns false in the latter case.
+static bool connection_drain_buffered(ClientContext* ctx) {
+    if (ctx->inbuf_len == 0) return true;
+    ssize_t consumed = connection_process(ctx, ctx->inbuf, ctx->inbuf_len);
+    if (consumed < 0) return false;
+    if (consumed > 0) {
+        ctx->inbuf_len -= (size_t)consumed;
+        memmove(ctx->inbuf, ctx->inbuf + consumed, ctx->inbuf_len);
+    }
+    return true;
+}
+
+void req_stream_resume(Response* res) {
+    if (!res) return;
+
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx || !ctx->body_stream || !ctx->body_stream->paused) return;
+    ctx->body_stream->paused = false;
+
+    // Flush body bytes that arrived before the pause took effect (which
+    // may finish the stream and dispatch pipelined requests), then
+    // reopen the socket unless something else owns it now
+    if (!connection_drain_buffered(ctx)) return;
+    if (!ctx->async_pending && !ctx->file_send &&
+        !uv_is_closing((uv_handle_t*)ctx->stream)) {
+        uv_read_start(ctx->stream, alloc_buffer, on_read);
+        connection_arm_deadline(ctx);
+    }
+}
+
+static void file_send_finish(FileSend* fsend, bool ok) {
+    uv_fs_t creq;
+    uv_fs_close(NULL, &creq, fsend->file_fd, NULL);
+    uv_fs_req_cleanup(&creq);
+
+    ClientContext* ctx = fsend->ctx;
+    free(fsend);
+    if (!ctx) return;
+
+    ctx->file_send = NULL;
+    if (!ok) {
+        uv_close((uv_handle_t*)ctx->stream, on_client_close);
+    } else if (ctx->close_after_send || !ctx->keep_alive) {
+        connection_shutdown(ctx);
+    } else if (connection_drain_buffered(ctx) && !ctx->file_send) {
+        uv_read_start(ctx->stream, alloc_buffer, on_read);
+        connection_arm_deadline(ctx);
+    }
+}
+
+static void on_sendfile(uv_fs_t* req) {
+    FileSend* fsend = req->data;
+    ssize_t n = req->result;
+    uv_fs_req_cleanup(req);
+
+    if (!fsend->ctx) {
+        file_send_finish(fsend, false);
+        return;
+    }
+    if (n < 0 && n != UV_EAGAIN) {
+        reavix_log(LOG_DEBUG, NULL, "sendfile error: %s", uv_strerror((int)n));
+        file_send_finish(fsend, false);
+        return;
+    }
+
+    if (n > 0) {
+        fsend->offset += n;
+        fsend->remaining -= (size_t)n;
+    }
+    if (fsend->remaining == 0) {
+        file_send_finish(fsend, true);
+    } else {
+        file_send_next(fsend);  // also retries UV_EAGAIN
+    }
+}
+
+static void file_send_next(FileSend* fsend) {
+    size_t chunk = fsend->remaining < SENDFILE_CHUNK ? fsend->remaining : SENDFILE_CHUNK;
+    fsend->fs.data = fsend;
+    uv_fs_sendfile(&fsend->ctx->worker->loop, &fsend->fs, fsend->sock_fd,
+                   fsend->file_fd, fsend->offset, chunk, on_sendfile);
+}
+
+static void on_file_headers_written(uv_write_t* req, int status) {
+    FileSend* fsend = req->data;
+    if (status < 0 || !fsend->ctx) {
+        file_send_finish(fsend, false);
+        return;
+    }
+    file_send_next(fsend);
+}
+
+static const char* guess_content_type(const char* path) {
+    const char* ext = strrchr(path, '.');
+    if (!ext) return "application/octet-stream";
+    if (strcmp(ext, ".html") == 0) return "text/html";
+    if (strcmp(ext, ".css") == 0) return "text/css";
+    if (strcmp(ext, ".js") == 0) return "application/javascript";
+    if (strcmp(ext, ".json") == 0) return "application/json";
+    if (strcmp(ext, ".txt") == 0) return "text/plain";
+    if (strcmp(ext, ".svg") == 0) return "image/svg+xml";
+    if (strcmp(ext, ".png") == 0) return "image/png";
+    if (strcmp(ext, ".jpg") == 0 || strcmp(ext, ".jpeg") == 0) return "image/jpeg";
+    if (strcmp(ext, ".gif") == 0) return "image/gif";
+    if (strcmp(ext, ".pdf") == 0) return "application/pdf";
+    if (strcmp(ext, ".wasm") == 0) return "application/wasm";
+    return "application/octet-stream";
+}
+
+// Parse "bytes=start-end" (also "start-" and "-suffix") against a file
+// of file_size bytes. Returns false if the header is syntactically valid
+// but unsatisfiable; multi-range requests fall back to the full body.
+static bool parse_range_header(const char* range, int64_t file_size,
+                               int64_t* out_start, int64_t* out_end, bool* out_ranged) {
+    *out_ranged = false;
+    if (!range || strncmp(range, "bytes=", 6) != 0 || file_size == 0) return true;
+    range += 6;
+    if (strchr(range, ',')) return true;  // multi-range: serve the whole file
+
+    char* dash;
+    if (*range == '-') {
+        // Suffix form: last N bytes
+        int64_t suffix = strtoll(range + 1, &dash, 10);
+        if (*dash != '\0' || suffix <= 0) return true;
+        if (suffix > file_size) suffix = file_size;
+        *out_start = file_size - suffix;
+        *out_end = file_size - 1;
+    } else {
+        int64_t start = strtoll(range, &dash, 10);
+        if (*dash != '-' || start < 0) return true;
+        int64_t end = file_size - 1;
+        if (dash[1] != '\0') {
+            char* tail;
+            end = strtoll(dash + 1, &tail, 10);
+            if (*tail != '\0' || end < start) return true;
+            if (end >= file_size) end = file_size - 1;
+        }
+        if (start >= file_size) return false;  // 416
+        *out_start = start;
+        *out_end = end;
+    }
+    *out_ranged = true;
+    return true;
+}
+
+void res_send_file(Response* res, const char* filepath) {
+    if (!res || !filepath || res->_internal.headers_sent) return;
+
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx || ctx->file_send) return;
+    ReavixWorker* worker = ctx->worker;
+    uint64_t now_ms = uv_now(&worker->loop);
+
+    FileCacheEntry* entry = file_cache_lookup(worker, filepath, now_ms);
+    if (!entry) {
+        int fd = open(filepath, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            res_send_error(res, 404, "Not Found");
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            close(fd);
+            res_send_error(res, 404, "Not Found");
+            return;
+        }
+        entry = file_cache_insert(worker, filepath, fd, &st, now_ms);
+        if (!entry) {
+            close(fd);
+            res_send_error(res, 500, "Internal Server Error");
+            return;
+        }
+    }
+
+    // Validators come from the cached stat, so conditional GETs
+    // short-circuit to 304 without touching the filesystem
+    res_set_header(res, "ETag", entry->etag);
+    res_set_header(res, "Last-Modified", entry->last_modified);
+    res_set_header(res, "Accept-Ranges", "bytes");
+
+    const Request* req = ctx->current_req;
+    const char* if_none_match = req ? req_get_header(req, "If-None-Match") : NULL;
+    const char* if_modified = req ? req_get_header(req, "If-Modified-Since") : NULL;
+    if ((if_none_match && strcmp(if_none_match, entry->etag) == 0) ||
+        (!if_none_match && if_modified && strcmp(if_modified, entry->last_modified) == 0)) {
+        res->status_code = 304;
+        res->content = NULL;
+        res->content_length = 0;
+        send_response(res);
+        return;
+    }
+
+    if (!res_has_header(res, "Content-Type")) {
+        res_set_header(res, "Content-Type", guess_content_type(filepath));
+    }
+
+    int64_t file_size = entry->st.st_size;
+    int64_t start = 0;
+    int64_t end = file_size > 0 ? file_size - 1 : -1;
+    bool ranged = false;
+    const char* range = req ? req_get_header(req, "Range") : NULL;
+    if (!parse_range_header(range, file_size, &start, &end, &ranged)) {
+        char unsat[64];
+        snprintf(unsat, sizeof(unsat), "bytes */%lld", (long long)file_size);
+        res_set_header(res, "Content-Range", unsat);
+        res_send_error(res, 416, "Range Not Satisfiable");
+        return;
+    }
+    if (ranged) {
+        res->status_code = 206;
+        char content_range[96];
+        snprintf(content_range, sizeof(content_range), "bytes %lld-%lld/%lld",
+            (long long)start, (long long)end, (long long)file_size);
+        res_set_header(res, "Content-Range", content_range);
+    }
+
+    size_t total = file_size > 0 ? (size_t)(end - start + 1) : 0;
+    if (total == 0) {
+        // Empty file or empty range: the header-only path suffices
+        res->content = NULL;
+        res->content_length = 0;
+        send_response(res);
+        return;
+    }
+
+    // Small mapped files are served straight from memory; a negotiated
+    // encoding becomes a variant lookup instead of a per-request
+    // compress_data() call
+    if (entry->map) {
+        CompressionType type = resolve_compression(res->_internal.compression);
+        if (!ranged && type != COMPRESSION_NONE &&
+            (size_t)file_size >= reavix_state.compression_threshold) {
+            char* variant;
+            size_t variant_len;
+            if (file_cache_variant(worker, entry, type, &variant, &variant_len)) {
+                res_set_header(res, "Content-Encoding", compression_encoding_name(type));
+                res->content = variant;
+                res->content_length = variant_len;
+                send_response(res);
+                return;
+            }
+        }
+        res->content = entry->map + start;
+        res->content_length = total;
+        send_response(res);
+        return;
+    }
+
+    // Large files stream through the sendfile chain on a dup of the
+    // cached fd, so eviction cannot close it out from under a transfer
+    int fd = dup(entry->fd);
+    uv_os_fd_t sock_fd;
+    FileSend* fsend = malloc(sizeof(FileSend));
+    if (fd < 0 || !fsend || uv_fileno((uv_handle_t*)ctx->stream, &sock_fd) != 0) {
+        if (fd >= 0) close(fd);
+        free(fsend);
+        res_send_error(res, 500, "Internal Server Error");
+        return;
+    }
+
+    fsend->ctx = ctx;
+    fsend->sock_fd = sock_fd;
+    fsend->file_fd = fd;
+    fsend->offset = start;
+    fsend->remaining = total;
+
+    // Content-Length covers the (possibly partial) body the sendfile
+    // chain will deliver; the header block flushes through uv's queue
+    // and its completion callback starts the chain, so ordering holds.
+    res->content_length = total;
+    int headers_len = build_response_headers(res, ctx->worker, fsend->headers,
+                                             WRITE_INLINE_SIZE, true);
+
+    uv_read_stop(ctx->stream);
+    ctx->file_send = fsend;
+    res->_internal.headers_sent = true;
+
+    fsend->write.data = fsend;
+    uv_buf_t buf = uv_buf_init(fsend->headers, (unsigned int)headers_len);
+    uv_write(&fsend->write, ctx->stream, &buf, 1, on_file_headers_written);
+}
+
+// Async handler completion. While an async handler owns a request the
+// connection's arena is left alone and reads stay paused; completion
+// runs on the loop thread and finishes the request cycle.
+
+typedef struct {
+    uv_work_t work;
+    Request* req;
+    Response* res;
+    RouteHandler handler;
+} HandlerWork;
+
+static void on_handler_work(uv_work_t* work) {
+    HandlerWork* hw = work->data;
+    hw->handler(hw->req, hw->res);
+}
+
+static void on_handler_work_done(uv_work_t* work, int status) {
+    HandlerWork* hw = work->data;
+    if (status < 0 && !hw->res->_internal.headers_sent) {
+        hw->res->status_code = 500;
+    }
+    res_complete(hw->res);
+    free(hw);
+}
+
+// Run a ROUTE_MODE_WORK handler on the libuv thread pool; completion
+// fires back on this worker's loop.
+static bool handler_offload(ReavixWorker* worker, Request* req, Response* res,
+                            RouteHandler handler) {
+    HandlerWork* hw = malloc(sizeof(HandlerWork));
+    if (!hw) return false;
+    hw->req = req;
+    hw->res = res;
+    hw->handler = handler;
+    hw->work.data = hw;
+    if (uv_queue_work(&worker->loop, &hw->work,
+                      on_handler_work, on_handler_work_done) != 0) {
+        free(hw);
+        return false;
+    }
+    return true;
+}
+
+void res_complete(Response* res) {
+    if (!res || res->_internal.async_done) return;
+    res->_internal.async_done = true;
+
+    if (!res->_internal.headers_sent) send_response(res);
+
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx || !ctx->async_pending) return;  // dispatch frame still active
+
+    ctx->async_pending = false;
+    arena_reset(&ctx->arena);
+
+    if (!ctx->keep_alive) {
+        connection_shutdown(ctx);
+        return;
+    }
+    if (connection_drain_buffered(ctx) && !ctx->async_pending &&
+        !ctx->file_send && !uv_is_closing((uv_handle_t*)ctx->stream)) {
+        uv_read_start(ctx->stream, alloc_buffer, on_read);
+        connection_arm_deadline(ctx);
+    }
+}
+
+void res_send_error(Response* res, int code, const char* message) {
+    if (!res) return;
+
+    res->status_code = code;
+    res_release(res, res->content);
+    res->content = res_strdup(res, message ? message : get_status_text(code));
+    res->content_length = strlen(res->content);
+    res_set_header(res, "Content-Type", "text/plain");
+    send_response(res);
+}
+
+bool res_write(Response* res, const char* data, size_t len) {
+    if (!res || !data || len == 0) return false;
+
+    char* grown;
+    if (res->_internal.arena) {
+        // Bump allocators can't realloc in place; copy-grow instead
+        grown = arena_alloc(res->_internal.arena, res->content_length + len);
+        if (!grown) return false;
+        if (res->content_length > 0) {
+            memcpy(grown, res->content, res->content_length);
+        }
+    } else {
+        grown = realloc(res->content, res->content_length + len);
+        if (!grown) return false;
+    }
+
+    memcpy(grown + res->content_length, data, len);
+    res->content = grown;
+    res->content_length += len;
+    return true;
+}
+
+void res_set_header(Response* res, const char* key, const char* value) {
+    if (!res || !key || !value) return;
+
+    // Replace an existing header of the same name
+    for (size_t i = 0; i < res->_internal.header_count; i++) {
+        if (strcasecmp(res->_internal.header_names[i], key) == 0) {
+            res_release(res, res->_internal.header_values[i]);
+            res->_internal.header_values[i] = res_strdup(res, value);
+            return;
+        }
+    }
+
+    char** names;
+    char** values;
+    if (res->_internal.arena) {
+        // Copy-grow out of the arena; the old arrays are reclaimed by
+        // the end-of-request reset
+        names = res_alloc(res, (res->_internal.header_count + 1) * sizeof(char*));
+        values = res_alloc(res, (res->_internal.header_count + 1) * sizeof(char*));
+        if (!names || !values) return;
+        if (res->_internal.header_count > 0) {
+            memcpy(names, res->_internal.header_names,
+                res->_internal.header_count * sizeof(char*));
+            memcpy(values, res->_internal.header_values,
+                res->_internal.header_count * sizeof(char*));
+        }
+    } else {
+        names = realloc(res->_internal.header_names,
+            (res->_internal.header_count + 1) * sizeof(char*));
+        values = realloc(res->_internal.header_values,
+            (res->_internal.header_count + 1) * sizeof(char*));
+        if (!names || !values) return;
+    }
+
+    res->_internal.header_names = names;
+    res->_internal.header_values = values;
+    names[res->_internal.header_count] = res_strdup(res, key);
+    values[res->_internal.header_count] = res_strdup(res, value);
+    res->_internal.header_count++;
+}
+
+bool res_has_header(const Response* res, const char* key) {
+    if (!res || !key) return false;
+
+    for (size_t i = 0; i < res->_internal.header_count; i++) {
+        if (strcasecmp(res->_internal.header_names[i], key) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void res_remove_header(Response* res, const char* key) {
+    if (!res || !key) return;
+
+    for (size_t i = 0; i < res->_internal.header_count; i++) {
+        if (strcasecmp(res->_internal.header_names[i], key) == 0) {
+            res_release(res, res->_internal.header_names[i]);
+            res_release(res, res->_internal.header_values[i]);
+            res->_internal.header_names[i] = res->_internal.header_names[res->_internal.header_count - 1];
+            res->_internal.header_values[i] = res->_internal.header_values[res->_internal.header_count - 1];
+            res->_internal.header_count--;
+            return;
+        }
+    }
+}
+
+// Request accessors
+const char* req_get_header(const Request* req, const char* key) {
+    if (!req || !key) return NULL;
+
+    for (size_t i = 0; i < req->_internal.header_count; i++) {
+        if (strcasecmp(req->_internal.header_names[i], key) == 0) {
+            return req->_internal.header_values[i];
+        }
+    }
+    return NULL;
+}
+
+const char* req_get_param(const Request* req, const char* key) {
+    if (!req || !key) return NULL;
+
+    for (size_t i = 0; i < req->_internal.param_count; i++) {
+        if (strcmp(req->_internal.params[i].name, key) == 0) {
+            return req->_internal.params[i].value;
+        }
+    }
+    return NULL;
+}
+
+size_t req_get_param_len(const Request* req, const char* key) {
+    if (!req || !key) return 0;
+
+    for (size_t i = 0; i < req->_internal.param_count; i++) {
+        if (strcmp(req->_internal.params[i].name, key) == 0) {
+            return req->_internal.params[i].value_len;
+        }
+    }
+    return 0;
+}
+
+const char* req_get_body(const Request* req) {
+    return req ? req->body : NULL;
+}
+
+size_t req_get_body_length(const Request* req) {
+    return req ? req->body_length : 0;
+}
+
+// Write request pool
+static WriteReq* write_req_acquire(ReavixWorker* worker) {
+    WriteReq* wr;
+    if (worker && worker->write_pool) {
+        wr = worker->write_pool;
+        worker->write_pool = wr->next;
+    } else {
+        wr = malloc(sizeof(WriteReq));
+        if (!wr) return NULL;
+    }
+    wr->next = NULL;
+    wr->worker = worker;
+    wr->payload = NULL;
+    wr->req.data = wr;
+    return wr;
+}
+
+static void write_req_release(WriteReq* wr) {
+    free(wr->payload);
+    wr->payload = NULL;
+    if (wr->worker) {
+        wr->next = wr->worker->write_pool;
+        wr->worker->write_pool = wr;
+    } else {
+        free(wr);
+    }
+}
+
+static void on_pooled_write(uv_write_t* req, int status) {
+    if (status < 0) {
+        reavix_log(LOG_DEBUG, NULL, "Write error: %s", uv_strerror(status));
+    }
+    write_req_release(req->data);
+}
+
+// Status lines pre-rendered as complete "HTTP/1.1 nnn Reason\r\n" blobs,
+// directly indexed by status code so the builder copies one blob instead
+// of formatting. The bare reason phrase rides along for error bodies.
+typedef struct {
+    const char* line;
+    uint8_t line_len;
+    const char* text;
+} StatusEntry;
+
+#define STATUS_LINE(code, reason) \
+    [code] = { "HTTP/1.1 " #code " " reason "\r\n", \
+               (uint8_t)(sizeof("HTTP/1.1 " #code " " reason "\r\n") - 1), reason }
+
+static const StatusEntry status_table[600] = {
+    STATUS_LINE(101, "Switching Protocols"),
+    STATUS_LINE(200, "OK"),
+    STATUS_LINE(201, "Created"),
+    STATUS_LINE(204, "No Content"),
+    STATUS_LINE(206, "Partial Content"),
+    STATUS_LINE(301, "Moved Permanently"),
+    STATUS_LINE(302, "Found"),
+    STATUS_LINE(304, "Not Modified"),
+    STATUS_LINE(400, "Bad Request"),
+    STATUS_LINE(401, "Unauthorized"),
+    STATUS_LINE(403, "Forbidden"),
+    STATUS_LINE(404, "Not Found"),
+    STATUS_LINE(413, "Payload Too Large"),
+    STATUS_LINE(416, "Range Not Satisfiable"),
+    STATUS_LINE(429, "Too Many Requests"),
+    STATUS_LINE(500, "Internal Server Error"),
+    STATUS_LINE(503, "Service Unavailable"),
+};
+
+// Header lines the framework itself emits on nearly every response,
+// interned as pre-serialized blobs. Anything not in the table takes the
+// generic name/value copy path.
+typedef struct {
+    const char* name;
+    const char* value;
+    const char* blob;
+    size_t blob_len;
+} InternedHeader;
+
+#define HDR_BLOB(name, value) \
+    { name, value, name ": " value "\r\n", sizeof(name ": " value "\r\n") - 1 }
+
+static const InternedHeader interned_headers[] = {
+    HDR_BLOB("Content-Type", "application/json"),
+    HDR_BLOB("Content-Type", "text/plain"),
+    HDR_BLOB("Content-Type", "text/html"),
+    HDR_BLOB("Content-Type", "text/plain; version=0.0.4"),
+    HDR_BLOB("Content-Encoding", "gzip"),
+    HDR_BLOB("Content-Encoding", "br"),
+    HDR_BLOB("Content-Encoding", "deflate"),
+    HDR_BLOB("Transfer-Encoding", "chunked"),
+    HDR_BLOB("Connection", "close"),
+    HDR_BLOB("Connection", "keep-alive"),
+    HDR_BLOB("Accept-Ranges", "bytes"),
+};
+
+static const InternedHeader* header_intern_lookup(const char* name, const char* value) {
+    for (size_t i = 0; i < sizeof(interned_headers) / sizeof(interned_headers[0]); i++) {
+        if (strcasecmp(interned_headers[i].name, name) == 0 &&
+            strcmp(interned_headers[i].value, value) == 0) {
+            return &interned_headers[i];
+        }
+    }
+    return NULL;
+}
+
+// Decimal formatter for the builder: writes the digits of v into dst
+// (no NUL) and returns how many
+static size_t fmt_u64(char* dst, uint64_t v) {
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + (v % 10));
+        v /= 10;
+    } while (v);
+    for (size_t i = 0; i < n; i++) dst[i] = tmp[n - 1 - i];
+    return n;
+}
+
+// Serialize the status line and header block into dst with table-driven
+// memcpy assembly: pre-rendered status line, interned blobs for the
+// framework's own headers, and the only formatting left is the
+// Content-Length digits. Headers that don't fit in cap are dropped
+// whole. The terminating blank line is included; Content-Length is
+// optional so the chunked path can reuse this.
+static int build_response_headers(Response* res, ReavixWorker* worker,
+                                  char* dst, size_t cap, bool include_length) {
+    size_t len;
+
+    const StatusEntry* st =
+        (res->status_code >= 0 && res->status_code < 600)
+            ? &status_table[res->status_code] : NULL;
+    if (st && st->line) {
+        memcpy(dst, st->line, st->line_len);
+        len = st->line_len;
+    } else {
+        len = (size_t)snprintf(dst, cap, "HTTP/1.1 %d Unknown\r\n", res->status_code);
+    }
+
+    // Cached Date line, re-rendered once per second by the worker's
+    // clock timer; skipped if a handler or plugin set its own
+    if (worker && worker->date_line_len &&
+        len + worker->date_line_len <= cap && !res_has_header(res, "Date")) {
+        memcpy(dst + len, worker->date_line, worker->date_line_len);
+        len += worker->date_line_len;
+    }
+
+    for (size_t i = 0; i < res->_internal.header_count; i++) {
+        const char* name = res->_internal.header_names[i];
+        const char* value = res->_internal.header_values[i];
+
+        const InternedHeader* ih = header_intern_lookup(name, value);
+        if (ih) {
+            if (len + ih->blob_len > cap) continue;
+            memcpy(dst + len, ih->blob, ih->blob_len);
+            len += ih->blob_len;
+            continue;
+        }
+
+        size_t name_len = strlen(name);
+        size_t value_len = strlen(value);
+        if (len + name_len + value_len + 4 > cap) continue;
+        memcpy(dst + len, name, name_len);
+        len += name_len;
+        dst[len++] = ':';
+        dst[len++] = ' ';
+        memcpy(dst + len, value, value_len);
+        len += value_len;
+        dst[len++] = '\r';
+        dst[len++] = '\n';
+    }
+
+    if (include_length) {
+        // "Content-Length: " + at most 20 digits + "\r\n\r\n"
+        if (len + 16 + 20 + 4 <= cap) {
+            memcpy(dst + len, "Content-Length: ", 16);
+            len += 16;
+            len += fmt_u64(dst + len, res->content_length);
+            memcpy(dst + len, "\r\n\r\n", 4);
+            len += 4;
+        }
+    } else if (len + 2 <= cap) {
+        dst[len++] = '\r';
+        dst[len++] = '\n';
+    }
+    return (int)len;
+}
+
+static void send_response(Response* res) {
+    if (!res || res->_internal.headers_sent) return;
+
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx) return;
+
+    WriteReq* wr = write_req_acquire(ctx->worker);
+    if (!wr) return;
+
+    // Build headers into the pooled buffer
+    char* headers = wr->inline_buf;
+    int headers_len = build_response_headers(res, ctx->worker, headers,
+                                             WRITE_INLINE_SIZE, true);
+
+    // Small responses: append the body to the headers so the common JSON
+    // reply goes out as one contiguous buffer in one syscall/segment.
+    if (res->content_length > 0 && res->content &&
+        (size_t)headers_len + res->content_length <= WRITE_INLINE_SIZE) {
+        memcpy(headers + headers_len, res->content, res->content_length);
+        uv_buf_t buf = uv_buf_init(headers, headers_len + res->content_length);
+        uv_write(&wr->req, ctx->stream, &buf, 1, on_pooled_write);
+        res->_internal.headers_sent = true;
+        return;
+    }
+
+    // Large responses: single writev with a two-element vector. The body
+    // is copied out of the arena since the write outlives the request.
+    unsigned int nbufs = 1;
+    uv_buf_t bufs[2];
+    bufs[0] = uv_buf_init(headers, headers_len);
+
+    if (res->content_length > 0 && res->content) {
+        wr->payload = malloc(res->content_length);
+        if (!wr->payload) {
+            write_req_release(wr);
+            return;
+        }
+        memcpy(wr->payload, res->content, res->content_length);
+        bufs[1] = uv_buf_init(wr->payload, res->content_length);
+        nbufs = 2;
+    }
+
+    uv_write(&wr->req, ctx->stream, bufs, nbufs, on_pooled_write);
+    res->_internal.headers_sent = true;
+}
+
+// Queue one chunked-transfer frame: hex size line, payload, CRLF.
+// A zero-length chunk emits the stream terminator.
+static bool send_chunk(ClientContext* ctx, const char* data, size_t len) {
+    char prefix[16];
+    int prefix_len = snprintf(prefix, sizeof(prefix), "%zx\r\n", len);
+
+    WriteReq* wr = write_req_acquire(ctx->worker);
+    if (!wr) return false;
+
+    wr->payload = malloc((size_t)prefix_len + len + 2);
+    if (!wr->payload) {
+        write_req_release(wr);
+        return false;
+    }
+    memcpy(wr->payload, prefix, prefix_len);
+    if (len > 0) memcpy(wr->payload + prefix_len, data, len);
+    memcpy(wr->payload + prefix_len + len, "\r\n", 2);
+
+    uv_buf_t buf = uv_buf_init(wr->payload, (unsigned int)(prefix_len + len + 2));
+    uv_write(&wr->req, ctx->stream, &buf, 1, on_pooled_write);
+    return true;
+}
+
+// Streaming compression path for large bodies: headers go out with
+// Transfer-Encoding: chunked, then the body is deflated through the
+// worker's pooled stream in COMPRESS_CHUNK_SIZE slices, each queued as
+// its own chunk so compression and transmission pipeline instead of
+// buffering the fully compressed body.
+static void send_response_compressed_chunked(Response* res, CompressionType type) {
+    if (!res || res->_internal.headers_sent) return;
+
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx) return;
+
+    z_stream* strm = worker_deflate_stream(ctx->worker, type);
+    if (!strm) return;  // caller falls back to the one-shot path
+
+    res_set_header(res, "Transfer-Encoding", "chunked");
+    res_set_header(res, "Content-Encoding", compression_encoding_name(type));
+
+    WriteReq* wr = write_req_acquire(ctx->worker);
+    if (!wr) return;
+    int headers_len = build_response_headers(res, ctx->worker, wr->inline_buf,
+                                             WRITE_INLINE_SIZE, false);
+    uv_buf_t header_buf = uv_buf_init(wr->inline_buf, headers_len);
+    uv_write(&wr->req, ctx->stream, &header_buf, 1, on_pooled_write);
+
+    strm->next_in = (Bytef*)res->content;
+    strm->avail_in = res->content_length;
+
+    char out[COMPRESS_CHUNK_SIZE];
+    int ret;
+    do {
+        strm->next_out = (Bytef*)out;
+        strm->avail_out = sizeof(out);
+        ret = deflate(strm, Z_FINISH);
+
+        size_t produced = sizeof(out) - strm->avail_out;
+        if (produced > 0 && !send_chunk(ctx, out, produced)) break;
+    } while (ret == Z_OK);
+
+    send_chunk(ctx, NULL, 0);
+    res->_internal.headers_sent = true;
+}
+
+// Plugin system
+void reavix_register_plugin(Plugin plugin) {
+    if (reavix_state.plugin_count >= MAX_PLUGINS) return;
+
+    pthread_mutex_lock(&reavix_state.mutex);
+    reavix_state.plugins[reavix_state.plugin_count++] = plugin;
+
+    if (plugin.init) {
+        plugin.init();
+    }
+    if (plugin.pre_handler) {
+        middleware_compile_locked();
+    }
+    pthread_mutex_unlock(&reavix_state.mutex);
+}
+
+// Middleware support
+void reavix_use(Middleware middleware) {
+    if (reavix_state.middleware_count >= MAX_MIDDLEWARE) return;
+
+    pthread_mutex_lock(&reavix_state.mutex);
+    reavix_state.middleware[reavix_state.middleware_count++] = middleware;
+    middleware_compile_locked();
+    pthread_mutex_unlock(&reavix_state.mutex);
+}
+
+// WebSocket support.
+//
+// Frames are encoded once into a refcounted buffer shared by every
+// recipient's uv_write. Fan-out is two-phase because libuv handles may
+// only be touched from their owning loop's thread while broadcast and
+// publish run on whatever thread calls them: the caller encodes the
+// shared frames and posts a delivery to every worker's MPSC inbox
+// (ws_delivery_post), and each worker drains its inbox on its own loop
+// (on_ws_async), walking its dedicated WebSocket list — or, for topic
+// deliveries, the subscribers it owns — instead of scanning the whole
+// connection table. Slow clients are handled by watermark on their
+// queued frame bytes: new frames are dropped past WS_QUEUE_DROP_BYTES
+// (ticks are perishable), and the connection is closed past
+// WS_QUEUE_CLOSE_BYTES.
+#define WS_QUEUE_DROP_BYTES  (256 * 1024)
+#define WS_QUEUE_CLOSE_BYTES (1024 * 1024)
+
+typedef struct SharedFrame {
+    _Atomic uint32_t refs;
+    size_t len;
+    char data[];
+} SharedFrame;
+
+// Encode a server-to-client text frame (FIN, no masking) once.
+static SharedFrame* ws_frame_encode(const char* message, size_t msg_len) {
+    SharedFrame* frame = malloc(sizeof(SharedFrame) + msg_len + 10);
+    if (!frame) return NULL;
+    atomic_init(&frame->refs, 1);
+
+    char* p = frame->data;
+    p[0] = (char)0x81;  // FIN + text frame
+    size_t header;
+    if (msg_len <= 125) {
+        p[1] = (char)msg_len;
+        header = 2;
+    } else if (msg_len <= 65535) {
+        p[1] = 126;
+        p[2] = (char)((msg_len >> 8) & 0xFF);
+        p[3] = (char)(msg_len & 0xFF);
+        header = 4;
+    } else {
+        p[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            p[2 + i] = (char)(((uint64_t)msg_len >> (56 - 8 * i)) & 0xFF);
+        }
+        header = 10;
+    }
+    memcpy(p + header, message, msg_len);
+    frame->len = header + msg_len;
+    return frame;
+}
+
+static void shared_frame_unref(SharedFrame* frame) {
+    if (atomic_fetch_sub_explicit(&frame->refs, 1, memory_order_acq_rel) == 1) {
+        free(frame);
+    }
+}
+
+// permessage-deflate (RFC 7692). The upgrade response negotiates
+// server_no_context_takeover, so every message is compressed
+// self-contained: that is what makes a single deflated frame valid for
+// every subscriber at once — with context takeover each connection's
+// compressed bytes would depend on its own message history and nothing
+// could be shared. The deflate stream itself is pooled like the HTTP
+// ones (lazy init, deflateReset() between messages); it is a single
+// mutex-guarded stream rather than per-worker because broadcast and
+// publish run on whatever thread calls them, outside any worker loop.
+static z_stream ws_deflate_stream;
+static bool ws_deflate_stream_init;
+static pthread_mutex_t ws_deflate_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Encode a compressed text frame (FIN + RSV1). Returns NULL when the
+// message does not shrink, so callers fall back to the plain encoding —
+// permitted per message under RFC 7692.
+static SharedFrame* ws_frame_encode_deflated(const char* message, size_t msg_len) {
+    pthread_mutex_lock(&ws_deflate_mutex);
+
+    if (!ws_deflate_stream_init) {
+        // Raw deflate, full window; sliding-window state is discarded
+        // per message via deflateReset (server_no_context_takeover)
+        if (deflateInit2(&ws_deflate_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            pthread_mutex_unlock(&ws_deflate_mutex);
+            return NULL;
+        }
+        ws_deflate_stream_init = true;
+    } else {
+        deflateReset(&ws_deflate_stream);
+    }
+
+    size_t bound = deflateBound(&ws_deflate_stream, (uLong)msg_len);
+    SharedFrame* frame = malloc(sizeof(SharedFrame) + bound + 10);
+    if (!frame) {
+        pthread_mutex_unlock(&ws_deflate_mutex);
+        return NULL;
+    }
+    atomic_init(&frame->refs, 1);
+
+    // Compress past the widest possible header; the payload is moved
+    // back once its final size (and thus the header size) is known
+    ws_deflate_stream.next_in = (Bytef*)message;
+    ws_deflate_stream.avail_in = (uInt)msg_len;
+    ws_deflate_stream.next_out = (Bytef*)(frame->data + 10);
+    ws_deflate_stream.avail_out = (uInt)bound;
+    int ret = deflate(&ws_deflate_stream, Z_SYNC_FLUSH);
+    size_t produced = bound - ws_deflate_stream.avail_out;
+    pthread_mutex_unlock(&ws_deflate_mutex);
+
+    // Strip the 00 00 FF FF flush tail the receiver re-appends (7.2.1)
+    if (ret != Z_OK || produced < 4) {
+        free(frame);
+        return NULL;
+    }
+    size_t payload_len = produced - 4;
+    if (payload_len >= msg_len) {
+        free(frame);
+        return NULL;  // incompressible; plain frame is smaller
+    }
+
+    char* p = frame->data;
+    size_t header;
+    if (payload_len <= 125) {
+        p[1] = (char)payload_len;
+        header = 2;
+    } else if (payload_len <= 65535) {
+        p[1] = 126;
+        p[2] = (char)((payload_len >> 8) & 0xFF);
+        p[3] = (char)(payload_len & 0xFF);
+        header = 4;
+    } else {
+        p[1] = 127;
+        for (int i = 0; i < 8; i++) {
+            p[2 + i] = (char)(((uint64_t)payload_len >> (56 - 8 * i)) & 0xFF);
+        }
+        header = 10;
+    }
+    p[0] = (char)0xC1;  // FIN + RSV1 (compressed) + text frame
+    memmove(p + header, p + 10, payload_len);
+    frame->len = header + payload_len;
+    return frame;
+}
+
+// One posted fan-out: the message encoded at most twice (plain always,
+// deflated when it clears the compression threshold — recipients that
+// did not negotiate permessage-deflate fall back to plain), plus the
+// topic pattern for publishes. Workers own one node each; the frames
+// are shared through their refcounts.
+typedef struct WsDelivery {
+    SharedFrame* plain;
+    SharedFrame* deflated;  // NULL when not worthwhile
+    char* topic;            // malloc'd literal topic; NULL = broadcast
+    struct WsDelivery* next;
+} WsDelivery;
+
+static void ws_delivery_free(WsDelivery* d) {
+    if (d->plain) shared_frame_unref(d->plain);
+    if (d->deflated) shared_frame_unref(d->deflated);
+    free(d->topic);
+    free(d);
+}
+
+static SharedFrame* ws_delivery_frame_for(WsDelivery* d, ClientContext* ctx) {
+    if (ctx->ws_deflate && d->deflated) return d->deflated;
+    return d->plain;
+}
+
+// Push one delivery onto a worker's inbox and wake its loop. Safe from
+// any thread: the inbox is a lock-free Treiber stack and
+// uv_async_send is the one libuv call that is thread-safe.
+static void ws_delivery_post(ReavixWorker* worker, SharedFrame* plain,
+                             SharedFrame* deflated, const char* topic) {
+    WsDelivery* d = malloc(sizeof(WsDelivery));
+    if (!d) return;
+    d->topic = topic ? strdup(topic) : NULL;
+    if (topic && !d->topic) {
+        free(d);
+        return;
+    }
+    d->plain = plain;
+    d->deflated = deflated;
+    atomic_fetch_add_explicit(&plain->refs, 1, memory_order_relaxed);
+    if (deflated) atomic_fetch_add_explicit(&deflated->refs, 1, memory_order_relaxed);
+
+    d->next = atomic_load_explicit(&worker->ws_inbox, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&worker->ws_inbox, &d->next, d,
+                                                  memory_order_release,
+                                                  memory_order_relaxed)) {}
+    uv_async_send(&worker->ws_async);
+}
+
+// Encode a message's shared frames once and post the delivery to every
+// worker; each drains it against its own clients on its own loop.
+static void ws_fanout_post(const char* topic, const char* message) {
+    if (!reavix_state.workers) return;
+
+    size_t msg_len = strlen(message);
+    SharedFrame* plain = ws_frame_encode(message, msg_len);
+    if (!plain) return;
+    SharedFrame* deflated = msg_len >= reavix_state.compression_threshold
+                                ? ws_frame_encode_deflated(message, msg_len)
+                                : NULL;
+
+    for (size_t w = 0; w < reavix_state.worker_count; w++) {
+        ws_delivery_post(&reavix_state.workers[w], plain, deflated, topic);
+    }
+    shared_frame_unref(plain);  // drop the encoding references
+    if (deflated) shared_frame_unref(deflated);
+}
 
-    z_stream strm;
-    int ret;
-    size_t max_output = compressBound(input_len);
-    *output = malloc(max_output);
-    if (!*output) return false;
+typedef struct {
+    uv_write_t req;
+    ClientContext* ctx;
+    SharedFrame* frame;
+} WsWrite;
 
-    if (type == COMPRESSION_GZIP) {
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
-        ret = deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | 16, 8, Z_DEFAULT_STRATEGY);
-    } else {
-        strm.zalloc = Z_NULL;
-        strm.zfree = Z_NULL;
-        strm.opaque = Z_NULL;
-        ret = deflateInit(&strm, Z_DEFAULT_COMPRESSION);
+static void on_ws_write(uv_write_t* req, int status) {
+    WsWrite* ww = (WsWrite*)req;
+    ww->ctx->ws_queued_bytes -= ww->frame->len;
+    if (status < 0) {
+        reavix_log(LOG_DEBUG, NULL, "WebSocket write error: %s", uv_strerror(status));
     }
+    shared_frame_unref(ww->frame);
+    free(ww);
+}
+
+// Queue one shared frame on a client, taking a reference, with the
+// backpressure policy applied. Returns false if the frame was dropped
+// or the client was cut instead.
+static bool ws_client_queue_frame(ClientContext* ctx, SharedFrame* frame) {
+    if (uv_is_closing((uv_handle_t*)ctx->stream)) return false;
 
-    if (ret != Z_OK) {
-        free(*output);
+    if (ctx->ws_queued_bytes + frame->len > WS_QUEUE_CLOSE_BYTES) {
+        // Hopelessly behind: cut the connection rather than buffer on
+        uv_close((uv_handle_t*)ctx->stream, on_client_close);
         return false;
     }
+    if (ctx->ws_queued_bytes + frame->len > WS_QUEUE_DROP_BYTES) {
+        return false;  // drop this frame, keep the connection
+    }
 
-    strm.next_in = (Bytef*)input;
-    strm.avail_in = input_len;
-    strm.next_out = (Bytef*)*output;
-    strm.avail_out = max_output;
+    WsWrite* ww = malloc(sizeof(WsWrite));
+    if (!ww) return false;
+    ww->ctx = ctx;
+    ww->frame = frame;
+    atomic_fetch_add_explicit(&frame->refs, 1, memory_order_relaxed);
 
-    ret = deflate(&strm, Z_FINISH);
-    if (ret != Z_STREAM_END) {
-        deflateEnd(&strm);
-        free(*output);
+    uv_buf_t buf = uv_buf_init(frame->data, (unsigned int)frame->len);
+    if (uv_write(&ww->req, ctx->stream, &buf, 1, on_ws_write) != 0) {
+        shared_frame_unref(frame);
+        free(ww);
         return false;
     }
-
-    *output_len = max_output - strm.avail_out;
-    deflateEnd(&strm);
+    ctx->ws_queued_bytes += frame->len;
     return true;
 }
 
-// Rate limiting implementation
-static bool check_rate_limit(const char* path, const char* client_ip) {
-    // TODO: Implement actual rate limiting logic
-    // This would typically use a token bucket or sliding window algorithm
-    return true;
-}
+// Minimal SHA-1, needed only for the handshake accept key (RFC 6455).
+static void ws_sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint64_t bitlen = (uint64_t)len * 8;
+    size_t total = ((len + 8) / 64 + 1) * 64;
+    uint8_t block[64];
 
-// Initialize the framework
-bool reavix_init(size_t max_routes) {
-    if (max_routes == 0) return false;
+    for (size_t off = 0; off < total; off += 64) {
+        for (size_t i = 0; i < 64; i++) {
+            size_t idx = off + i;
+            if (idx < len) block[i] = data[idx];
+            else if (idx == len) block[i] = 0x80;
+            else if (idx >= total - 8) block[i] = (uint8_t)(bitlen >> (8 * (total - 1 - idx)));
+            else block[i] = 0;
+        }
 
-    memset(&reavix_state, 0, sizeof(reavix_state));
-    reavix_state.route_capacity = max_routes;
-    reavix_state.routes = malloc(max_routes * sizeof(RouteEntry));
-    if (!reavix_state.routes) return false;
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 |
+                   (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+        }
+        for (int i = 16; i < 80; i++) {
+            uint32_t v = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = (v << 1) | (v >> 31);
+        }
 
-    pthread_mutex_init(&reavix_state.mutex, NULL);
-    reavix_state.enabled_protocols = PROTOCOL_HTTP; // HTTP enabled by default
-    
-    // Initialize root node
-    reavix_state.root_node.segment = strdup("");
-    reavix_state.root_node.handler = NULL;
-    reavix_state.root_node.children = NULL;
-    reavix_state.root_node.param_child = NULL;
-    reavix_state.root_node.child_count = 0;
-    
-    return true;
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);           k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                    k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d);  k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                    k = 0xCA62C1D6; }
+            uint32_t t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+            e = d; d = c; c = (b << 30) | (b >> 2); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        out[4 * i] = (uint8_t)(h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)h[i];
+    }
 }
 
-// Route registration with rate limiting
-bool reavix_route(const char* method, const char* path, RouteHandler handler) {
-    if (!method || !path || !handler) return false;
+static void ws_base64(const uint8_t* in, size_t len, char* out) {
+    static const char tbl[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16 |
+                     (i + 1 < len ? (uint32_t)in[i + 1] << 8 : 0) |
+                     (i + 2 < len ? in[i + 2] : 0);
+        out[o++] = tbl[(v >> 18) & 63];
+        out[o++] = tbl[(v >> 12) & 63];
+        out[o++] = i + 1 < len ? tbl[(v >> 6) & 63] : '=';
+        out[o++] = i + 2 < len ? tbl[v & 63] : '=';
+    }
+    out[o] = '\0';
+}
 
-    pthread_mutex_lock(&reavix_state.mutex);
+// Answer the RFC 6455 handshake and move the connection out of the
+// HTTP request cycle. Returns false for plain HTTP requests.
+static bool try_websocket_upgrade(ClientContext* ctx, const Request* req) {
+    if (!(reavix_state.enabled_protocols & PROTOCOL_WS)) return false;
 
-    if (reavix_state.route_count >= reavix_state.route_capacity) {
-        pthread_mutex_unlock(&reavix_state.mutex);
-        return false;
-    }
+    const char* upgrade = req_get_header(req, "Upgrade");
+    const char* key = req_get_header(req, "Sec-WebSocket-Key");
+    if (!upgrade || strcasecmp(upgrade, "websocket") != 0 || !key) return false;
 
-    // Check for duplicate routes
-    for (size_t i = 0; i < reavix_state.route_count; ++i) {
-        if (strcmp(reavix_state.routes[i].method, method) == 0 && 
-            strcmp(reavix_state.routes[i].path, path) == 0) {
-            pthread_mutex_unlock(&reavix_state.mutex);
-            return false;
-        }
-    }
+    char concat[128];
+    int n = snprintf(concat, sizeof(concat),
+        "%s258EAFA5-E914-47DA-95CA-C5AB0DC85B11", key);
+    if (n < 0 || (size_t)n >= sizeof(concat)) return false;
 
-    // Add to flat route list
-    reavix_state.routes[reavix_state.route_count].method = strdup(method);
-    reavix_state.routes[reavix_state.route_count].path = strdup(path);
-    reavix_state.routes[reavix_state.route_count].handler = handler;
-    reavix_state.route_count++;
+    uint8_t digest[20];
+    ws_sha1((const uint8_t*)concat, (size_t)n, digest);
+    char accept[32];
+    ws_base64(digest, sizeof(digest), accept);
 
-    // Add to trie router
-    if (!trie_insert(&reavix_state.root_node, path, handler)) {
-        pthread_mutex_unlock(&reavix_state.mutex);
-        return false;
-    }
+    // permessage-deflate negotiation: accept with
+    // server_no_context_takeover (which a server may always add), so
+    // outgoing messages compress self-contained and broadcast frames
+    // can be shared. Incoming frames are not decoded by this layer, so
+    // no client-side parameters are needed.
+    const char* ext = req_get_header(req, "Sec-WebSocket-Extensions");
+    bool deflate = ext && strstr(ext, "permessage-deflate") != NULL;
 
-    pthread_mutex_unlock(&reavix_state.mutex);
+    WriteReq* wr = write_req_acquire(ctx->worker);
+    if (!wr) return false;
+    int len = snprintf(wr->inline_buf, WRITE_INLINE_SIZE,
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Accept: %s\r\n%s\r\n", accept,
+        deflate ? "Sec-WebSocket-Extensions: permessage-deflate; "
+                  "server_no_context_takeover\r\n"
+                : "");
+    uv_buf_t buf = uv_buf_init(wr->inline_buf, (unsigned int)len);
+    uv_write(&wr->req, ctx->stream, &buf, 1, on_pooled_write);
+
+    ws_client_attach(ctx);
+    ctx->ws_deflate = deflate;
     return true;
 }
 
-// Server implementation
-void reavix_server(uint16_t port) {
-    reavix_state.loop = uv_default_loop();
-    uv_tcp_init(reavix_state.loop, &reavix_state.server);
-
-    struct sockaddr_in addr;
-    uv_ip4_addr("0.0.0.0", port, &addr);
+// List maintenance around the upgrade handshake and teardown.
+static void ws_client_attach(ClientContext* ctx) {
+    if (ctx->websocket_connected) return;
+    ReavixWorker* worker = ctx->worker;
+    ctx->ws_prev = NULL;
+    ctx->ws_next = worker->ws_head;
+    if (worker->ws_head) worker->ws_head->ws_prev = ctx;
+    worker->ws_head = ctx;
+    ctx->is_websocket = true;
+    ctx->websocket_connected = true;
+    // Push channels are long-lived; HTTP deadlines no longer apply
+    timer_wheel_cancel(ctx);
+}
 
-    uv_tcp_bind(&reavix_state.server, (const struct sockaddr*)&addr, 0);
-    
-    int r = uv_listen((uv_stream_t*)&reavix_state.server, SOMAXCONN, on_connection);
-    if (r) {
-        reavix_log(LOG_FATAL, NULL, "Listen error: %s", uv_strerror(r));
-        return;
-    }
+static void ws_unsubscribe_all(ClientContext* ctx);
 
-    reavix_log(LOG_INFO, NULL, "Server running on port %d", port);
-    uv_run(reavix_state.loop, UV_RUN_DEFAULT);
+static void ws_client_detach(ClientContext* ctx) {
+    ws_unsubscribe_all(ctx);
+    if (!ctx->websocket_connected) return;
+    ReavixWorker* worker = ctx->worker;
+    if (ctx->ws_prev) ctx->ws_prev->ws_next = ctx->ws_next;
+    else worker->ws_head = ctx->ws_next;
+    if (ctx->ws_next) ctx->ws_next->ws_prev = ctx->ws_prev;
+    ctx->ws_prev = NULL;
+    ctx->ws_next = NULL;
+    ctx->websocket_connected = false;
 }
 
-// Connection handler
-static void on_connection(uv_stream_t* server, int status) {
-    if (status < 0) {
-        reavix_log(LOG_ERROR, NULL, "Connection error: %s", uv_strerror(status));
-        return;
-    }
+// Single-connection send: runs on the connection's own loop thread (the
+// handler or completion callback that holds the Response), so the frame
+// is queued directly without a trip through the inbox.
+void reavix_ws_send(Response* res, const char* message) {
+    if (!res || !message || !res->_internal.client) return;
 
-    uv_tcp_t* client = malloc(sizeof(uv_tcp_t));
-    uv_tcp_init(reavix_state.loop, client);
-    
-    if (uv_accept(server, (uv_stream_t*)client) == 0) {
-        // Add to client tracking
-        pthread_mutex_lock(&reavix_state.mutex);
-        if (reavix_state.client_capacity == 0) {
-            reavix_state.clients = malloc(10 * sizeof(ClientContext));
-            reavix_state.client_capacity = 10;
-        } else if (reavix_state.client_count >= reavix_state.client_capacity) {
-            reavix_state.client_capacity *= 2;
-            reavix_state.clients = realloc(reavix_state.clients, 
-                reavix_state.client_capacity * sizeof(ClientContext));
-        }
-        
-        ClientContext* ctx = &reavix_state.clients[reavix_state.client_count++];
-        ctx->stream = (uv_stream_t*)client;
-        ctx->is_websocket = false;
-        ctx->websocket_connected = false;
-        
-        pthread_mutex_unlock(&reavix_state.mutex);
-        
-        uv_read_start((uv_stream_t*)client, alloc_buffer, on_read);
-    } else {
-        uv_close((uv_handle_t*)client, NULL);
+    ClientContext* ctx = find_client_context(res->_internal.client);
+    if (!ctx || !ctx->is_websocket) return;
+
+    size_t msg_len = strlen(message);
+    SharedFrame* frame = NULL;
+    if (ctx->ws_deflate && msg_len >= reavix_state.compression_threshold) {
+        frame = ws_frame_encode_deflated(message, msg_len);
     }
+    if (!frame) frame = ws_frame_encode(message, msg_len);
+    if (!frame) return;
+    ws_client_queue_frame(ctx, frame);
+    shared_frame_unref(frame);  // drop the encoding reference
 }
 
-// Request handling
-static void handle_request(Request* req, Response* res) {
-    // Apply middleware
-    for (size_t i = 0; i < reavix_state.middleware_count; i++) {
-        bool continue_processing = true;
-        reavix_state.middleware[i](req, res, [](Request* r, Response* resp) {
-            // Next function implementation
-        });
-        
-        if (res->_internal.headers_sent) {
-            return;
-        }
-    }
+void reavix_ws_broadcast(const char* message) {
+    if (!message) return;
+    ws_fanout_post(NULL, message);
+}
 
-    // Apply pre-handler plugins
-    for (size_t i = 0; i < reavix_state.plugin_count; i++) {
-        if (reavix_state.plugins[i].pre_handler) {
-            reavix_state.plugins[i].pre_handler(req, res);
-            if (res->_internal.headers_sent) {
-                return;
+// Topic pub/sub engine.
+//
+// Patterns live in a segment trie shaped like the router's ('/'-split
+// segments, one node per segment), but with heap-linked children and
+// parent pointers: subscriptions hold stable node addresses and empty
+// branches are pruned as they unsubscribe, neither of which the
+// router's embedded-array nodes allow. "*" is the one-segment wildcard
+// (the router's ':param' without a name) and a trailing "#" swallows
+// the remainder. Each node carries an intrusive subscriber list;
+// publish encodes the frame once, walks the trie against the literal
+// topic, and fans the shared frame out to matching nodes' lists only.
+// One mutex guards the whole structure — subscribe churn and publish
+// rates are nowhere near the per-message hot path.
+
+typedef struct TopicNode {
+    char* segment;
+    struct TopicNode* parent;
+    struct TopicNode* child;    // first child
+    struct TopicNode* sibling;
+    struct WsSubscription* subs;
+} TopicNode;
+
+typedef struct WsSubscription {
+    TopicNode* topic;
+    ClientContext* ctx;
+    struct WsSubscription* topic_prev;  // topic's subscriber list
+    struct WsSubscription* topic_next;
+    struct WsSubscription* ctx_next;    // connection's subscription list
+} WsSubscription;
+
+static TopicNode topic_root;
+static pthread_mutex_t topics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Find the pattern's node, creating missing ones when create is set.
+// Caller holds topics_mutex.
+static TopicNode* topic_node_get(const char* pattern, bool create) {
+    char* copy = strdup(pattern);
+    if (!copy) return NULL;
+
+    TopicNode* current = &topic_root;
+    char* saveptr;
+    for (char* segment = strtok_r(copy, "/", &saveptr); segment && current;
+         segment = strtok_r(NULL, "/", &saveptr)) {
+        TopicNode* child = current->child;
+        while (child && strcmp(child->segment, segment) != 0) {
+            child = child->sibling;
+        }
+        if (!child) {
+            if (!create) {
+                current = NULL;
+                break;
+            }
+            child = calloc(1, sizeof(TopicNode));
+            if (!child || !(child->segment = strdup(segment))) {
+                free(child);
+                current = NULL;
+                break;
             }
+            child->parent = current;
+            child->sibling = current->child;
+            current->child = child;
         }
+        current = child;
     }
 
-    // Route handling
-    PathParam path_params[MAX_PARAMS];
-    size_t path_param_count = 0;
-    RouteHandler route_handler = NULL;
+    free(copy);
+    return current == &topic_root ? NULL : current;  // empty pattern
+}
 
-    pthread_mutex_lock(&reavix_state.mutex);
-    bool is_matched = trie_match(&reavix_state.root_node, req->path, 
-                                path_params, &path_param_count, &route_handler);
-    pthread_mutex_unlock(&reavix_state.mutex);
+// Drop now-empty nodes up the chain so per-entity topics don't
+// accumulate forever. Caller holds topics_mutex.
+static void topic_node_prune(TopicNode* node) {
+    while (node && node != &topic_root && !node->subs && !node->child) {
+        TopicNode* parent = node->parent;
+        TopicNode** link = &parent->child;
+        while (*link && *link != node) link = &(*link)->sibling;
+        if (*link) *link = node->sibling;
+        free(node->segment);
+        free(node);
+        node = parent;
+    }
+}
 
-    if (is_matched && route_handler) {
-        // Set path parameters
-        req->_internal.param_names = malloc(path_param_count * sizeof(char*));
-        req->_internal.param_values = malloc(path_param_count * sizeof(char*));
-        req->_internal.param_count = path_param_count;
+// Unlink one subscription from both its lists and free it. Caller holds
+// topics_mutex.
+static void ws_subscription_drop(WsSubscription* sub) {
+    if (sub->topic_prev) sub->topic_prev->topic_next = sub->topic_next;
+    else sub->topic->subs = sub->topic_next;
+    if (sub->topic_next) sub->topic_next->topic_prev = sub->topic_prev;
+
+    WsSubscription** link = &sub->ctx->ws_subs;
+    while (*link && *link != sub) link = &(*link)->ctx_next;
+    if (*link) *link = sub->ctx_next;
 
-        for (size_t i = 0; i < path_param_count; i++) {
-            req->_internal.param_names[i] = path_params[i].name;
-            req->_internal.param_values[i] = path_params[i].value;
+    topic_node_prune(sub->topic);
+    free(sub);
+}
+
+static void ws_unsubscribe_all(ClientContext* ctx) {
+    if (!ctx->ws_subs) return;
+    pthread_mutex_lock(&topics_mutex);
+    while (ctx->ws_subs) {
+        ws_subscription_drop(ctx->ws_subs);
+    }
+    pthread_mutex_unlock(&topics_mutex);
+}
+
+// Queue the delivery's frames on this worker's matching subscribers.
+// Runs on the owning loop during inbox drain; subscribers on other
+// workers are skipped — their own drain of the same delivery covers
+// them. Caller holds topics_mutex, which is also what keeps a
+// subscription's ctx alive here: detaching a client removes its
+// subscriptions under the same mutex, on this same loop.
+static void topic_deliver(ReavixWorker* worker, TopicNode* node, WsDelivery* d) {
+    WsSubscription* sub = node->subs;
+    while (sub) {
+        // Queueing may schedule the client's close; grab next first
+        WsSubscription* next = sub->topic_next;
+        if (sub->ctx->worker == worker) {
+            SharedFrame* frame = ws_delivery_frame_for(d, sub->ctx);
+            if (frame) ws_client_queue_frame(sub->ctx, frame);
         }
+        sub = next;
+    }
+}
 
-        route_handler(req, res);
-    } else {
-        res_send_error(res, 404, "Not Found");
+// Match the literal topic against the pattern trie. Both the static
+// child and the "*" child can match a segment, so the walk branches;
+// a "#" child matches any remainder.
+static void topic_walk(ReavixWorker* worker, TopicNode* node, const char* p,
+                       WsDelivery* d) {
+    while (*p == '/') p++;
+    if (!*p) {
+        topic_deliver(worker, node, d);
+        for (TopicNode* c = node->child; c; c = c->sibling) {
+            if (strcmp(c->segment, "#") == 0) topic_deliver(worker, c, d);
+        }
+        return;
     }
 
-    // Apply post-handler plugins
-    for (size_t i = 0; i < reavix_state.plugin_count; i++) {
-        if (reavix_state.plugins[i].post_handler) {
-            reavix_state.plugins[i].post_handler(req, res);
+    const char* seg = p;
+    while (*p && *p != '/') p++;
+    size_t seg_len = (size_t)(p - seg);
+
+    for (TopicNode* c = node->child; c; c = c->sibling) {
+        if (strcmp(c->segment, "#") == 0) {
+            topic_deliver(worker, c, d);
+        } else if (strcmp(c->segment, "*") == 0 ||
+                   (strncmp(c->segment, seg, seg_len) == 0 &&
+                    c->segment[seg_len] == '\0')) {
+            topic_walk(worker, c, p, d);
         }
     }
 }
 
-// Response implementation
-void res_send_json(Response* res, const char* json) {
-    if (!res || !json) return;
+// Drain this worker's delivery inbox, on its own loop. The exchange
+// detaches the whole stack at once; it is reversed first so clients
+// see frames in posting order.
+static void on_ws_async(uv_async_t* handle) {
+    ReavixWorker* worker = handle->data;
+    WsDelivery* d = atomic_exchange_explicit(&worker->ws_inbox, NULL,
+                                             memory_order_acquire);
+    WsDelivery* ordered = NULL;
+    while (d) {
+        WsDelivery* next = d->next;
+        d->next = ordered;
+        ordered = d;
+        d = next;
+    }
 
-    free(res->content);
-    res->content = strdup(json);
-    res->content_length = strlen(json);
-    res_set_header(res, "Content-Type", "application/json");
-    
-    if (res->_internal.compression != COMPRESSION_NONE) {
-        char* compressed;
-        size_t compressed_len;
-        if (compress_data(res->content, res->content_length, &compressed, &compressed_len, res->_internal.compression)) {
-            free(res->content);
-            res->content = compressed;
-            res->content_length = compressed_len;
-            
-            const char* encoding = "";
-            switch (res->_internal.compression) {
-                case COMPRESSION_GZIP: encoding = "gzip"; break;
-                case COMPRESSION_BROTLI: encoding = "br"; break;
-                case COMPRESSION_DEFLATE: encoding = "deflate"; break;
-                default: break;
+    while (ordered) {
+        WsDelivery* next = ordered->next;
+        if (ordered->topic) {
+            pthread_mutex_lock(&topics_mutex);
+            topic_walk(worker, &topic_root, ordered->topic, ordered);
+            pthread_mutex_unlock(&topics_mutex);
+        } else {
+            ClientContext* ctx = worker->ws_head;
+            while (ctx) {
+                // The queue step may close the client; grab next first
+                ClientContext* cnext = ctx->ws_next;
+                SharedFrame* frame = ws_delivery_frame_for(ordered, ctx);
+                if (frame) ws_client_queue_frame(ctx, frame);
+                ctx = cnext;
             }
-            res_set_header(res, "Content-Encoding", encoding);
         }
+        ws_delivery_free(ordered);
+        ordered = next;
     }
-    
-    send_response(res);
 }
 
-void send_response(Response* res) {
-    if (!res || res->_internal.headers_sent) return;
-    
+bool reavix_ws_subscribe(Response* res, const char* topic) {
+    if (!res || !topic || !*topic || !res->_internal.client) return false;
+
     ClientContext* ctx = find_client_context(res->_internal.client);
-    if (!ctx) return;
+    if (!ctx || !ctx->is_websocket) return false;
 
-    // Build headers
-    char headers[4096];
-    int headers_len = snprintf(headers, sizeof(headers), "HTTP/1.1 %d %s\r\n", 
-        res->status_code, get_status_text(res->status_code));
-    
-    for (size_t i = 0; i < res->_internal.header_count; i++) {
-        headers_len += snprintf(headers + headers_len, sizeof(headers) - headers_len, 
-            "%s: %s\r\n", res->_internal.header_names[i], res->_internal.header_values[i]);
-    }
-    
-    headers_len += snprintf(headers + headers_len, sizeof(headers) - headers_len, 
-        "Content-Length: %zu\r\n\r\n", res->content_length);
-    
-    // Send headers
-    uv_buf_t buf = uv_buf_init(headers, headers_len);
-    uv_write_t* write_req = malloc(sizeof(uv_write_t));
-    uv_write(write_req, ctx->stream, &buf, 1, on_write_complete);
-    
-    // Send body if exists
-    if (res->content_length > 0 && res->content) {
-        uv_buf_t body_buf = uv_buf_init(res->content, res->content_length);
-        uv_write_t* body_req = malloc(sizeof(uv_write_t));
-        uv_write(body_req, ctx->stream, &body_buf, 1, on_write_complete);
+    pthread_mutex_lock(&topics_mutex);
+
+    TopicNode* node = topic_node_get(topic, true);
+    if (!node) {
+        pthread_mutex_unlock(&topics_mutex);
+        return false;
     }
-    
-    res->_internal.headers_sent = true;
-}
 
-// Plugin system
-void reavix_register_plugin(Plugin plugin) {
-    if (reavix_state.plugin_count >= MAX_PLUGINS) return;
-    
-    pthread_mutex_lock(&reavix_state.mutex);
-    reavix_state.plugins[reavix_state.plugin_count++] = plugin;
-    
-    if (plugin.init) {
-        plugin.init();
+    // Idempotent: already subscribed to this exact pattern
+    for (WsSubscription* sub = ctx->ws_subs; sub; sub = sub->ctx_next) {
+        if (sub->topic == node) {
+            pthread_mutex_unlock(&topics_mutex);
+            return true;
+        }
     }
-    pthread_mutex_unlock(&reavix_state.mutex);
-}
 
-// Middleware support
-void reavix_use(Middleware middleware) {
-    if (reavix_state.middleware_count >= MAX_MIDDLEWARE) return;
-    
-    pthread_mutex_lock(&reavix_state.mutex);
-    reavix_state.middleware[reavix_state.middleware_count++] = middleware;
-    pthread_mutex_unlock(&reavix_state.mutex);
+    WsSubscription* sub = calloc(1, sizeof(WsSubscription));
+    if (!sub) {
+        topic_node_prune(node);
+        pthread_mutex_unlock(&topics_mutex);
+        return false;
+    }
+    sub->topic = node;
+    sub->ctx = ctx;
+    sub->topic_next = node->subs;
+    if (node->subs) node->subs->topic_prev = sub;
+    node->subs = sub;
+    sub->ctx_next = ctx->ws_subs;
+    ctx->ws_subs = sub;
+
+    pthread_mutex_unlock(&topics_mutex);
+    return true;
 }
 
-// WebSocket support
-void reavix_ws_send(Response* res, const char* message) {
-    if (!res || !message || !res->_internal.client) return;
-    
+void reavix_ws_unsubscribe(Response* res, const char* topic) {
+    if (!res || !topic || !res->_internal.client) return;
+
     ClientContext* ctx = find_client_context(res->_internal.client);
-    if (!ctx || !ctx->is_websocket) return;
-    
-    size_t msg_len = strlen(message);
-    size_t frame_len = msg_len + 10; // Max frame header size
-    char* frame = malloc(frame_len);
-    
-    // Simple text frame (no masking)
-    frame[0] = 0x81; // FIN + text frame
-    if (msg_len <= 125) {
-        frame[1] = msg_len;
-        memcpy(frame + 2, message, msg_len);
-        frame_len = msg_len + 2;
-    } else if (msg_len <= 65535) {
-        frame[1] = 126;
-        frame[2] = (msg_len >> 8) & 0xFF;
-        frame[3] = msg_len & 0xFF;
-        memcpy(frame + 4, message, msg_len);
-        frame_len = msg_len + 4;
-    } else {
-        // For very large messages (unlikely in this context)
-        frame[1] = 127;
-        // 64-bit length would go here
-        // But we'll just error for this example
-        free(frame);
-        return;
+    if (!ctx) return;
+
+    pthread_mutex_lock(&topics_mutex);
+    TopicNode* node = topic_node_get(topic, false);
+    if (node) {
+        for (WsSubscription* sub = ctx->ws_subs; sub; sub = sub->ctx_next) {
+            if (sub->topic == node) {
+                ws_subscription_drop(sub);
+                break;
+            }
+        }
     }
-    
-    uv_buf_t buf = uv_buf_init(frame, frame_len);
-    uv_write_t* write_req = malloc(sizeof(uv_write_t));
-    uv_write(write_req, ctx->stream, &buf, 1, on_write_complete);
+    pthread_mutex_unlock(&topics_mutex);
+}
+
+void reavix_ws_publish(const char* topic, const char* message) {
+    if (!topic || !message) return;
+    ws_fanout_post(topic, message);
 }
 
 // Compression support
@@ -397,10 +4482,32 @@ void res_compress(Response* res, CompressionType type) {
     res->_internal.compression = type;
 }
 
+void reavix_set_compression_threshold(size_t min_bytes) {
+    reavix_state.compression_threshold = min_bytes;
+}
+
+void reavix_set_timeouts(uint64_t header_read_ms, uint64_t body_read_ms, uint64_t idle_ms) {
+    if (header_read_ms) reavix_state.header_timeout_ms = header_read_ms;
+    if (body_read_ms) reavix_state.body_timeout_ms = body_read_ms;
+    if (idle_ms) reavix_state.idle_timeout_ms = idle_ms;
+}
+
+void reavix_set_listen_options(int backlog, int defer_accept_secs) {
+    if (backlog > 0) reavix_state.listen_backlog = backlog;
+    if (defer_accept_secs >= 0) reavix_state.defer_accept_secs = defer_accept_secs;
+}
+
+void reavix_set_ipc_path(const char* path) {
+    pthread_mutex_lock(&reavix_state.mutex);
+    free(reavix_state.ipc_path);
+    reavix_state.ipc_path = path ? strdup(path) : NULL;
+    pthread_mutex_unlock(&reavix_state.mutex);
+}
+
 // Rate limiting configuration
 void reavix_set_rate_limits(const char* path, RateLimitConfig config) {
     pthread_mutex_lock(&reavix_state.mutex);
-    
+
     // Find the route in the trie and set rate limiting
     TrieNode* current = &reavix_state.root_node;
     char* path_copy = strdup(path);
@@ -408,10 +4515,10 @@ void reavix_set_rate_limits(const char* path, RateLimitConfig config) {
         pthread_mutex_unlock(&reavix_state.mutex);
         return;
     }
-    
+
     char* saveptr;
     char* segment = strtok_r(path_copy, "/", &saveptr);
-    
+
     while (segment) {
         bool found = false;
         // Traverse static children first
@@ -422,24 +4529,28 @@ void reavix_set_rate_limits(const char* path, RateLimitConfig config) {
                 break;
             }
         }
-        
+
         // Traverse parameter child if static not found
         if (!found && current->param_child) {
             current = current->param_child;
             found = true;
         }
-        
+
         if (!found) {
             free(path_copy);
             pthread_mutex_unlock(&reavix_state.mutex);
             return;
         }
-        
+
         segment = strtok_r(NULL, "/", &saveptr);
     }
-    
-    // Set rate limit configuration in the trie node
-    current->rate_limit_config = config;
+
+    // Set rate limit configuration in the trie node and republish
+    current->rate_limit = config;
+    trie_publish();
+    if (atomic_load_explicit(&reavix_state.sealed, memory_order_relaxed)) {
+        router_seal_locked();
+    }
 
     free(path_copy);
     pthread_mutex_unlock(&reavix_state.mutex);
@@ -452,6 +4563,16 @@ void reavix_set_security_policy(SecurityPolicy policy) {
     pthread_mutex_unlock(&reavix_state.mutex);
 }
 
+// Error handler configuration
+void reavix_set_error_handler(ErrorHandler handler) {
+    reavix_state.error_handler = handler;
+}
+
+// Logging configuration
+void reavix_log_configure(LogConfig config) {
+    reavix_state.log_config = config;
+}
+
 // Protocol enablement
 void reavix_enable_protocol(uint8_t protocol) {
     pthread_mutex_lock(&reavix_state.mutex);
@@ -461,31 +4582,20 @@ void reavix_enable_protocol(uint8_t protocol) {
 
 // Helper functions
 static const char* get_status_text(int status_code) {
-    switch (status_code) {
-        case 200: return "OK";
-        case 201: return "Created";
-        case 204: return "No Content";
-        case 400: return "Bad Request";
-        case 401: return "Unauthorized";
-        case 403: return "Forbidden";
-        case 404: return "Not Found";
-        case 500: return "Internal Server Error";
-        case 503: return "Service Unavailable";
-        default: return "Unknown";
+    if (status_code >= 0 && status_code < 600 && status_table[status_code].text) {
+        return status_table[status_code].text;
     }
+    return "Unknown";
 }
 
 static ClientContext* find_client_context(uv_stream_t* stream) {
-    for (size_t i = 0; i < reavix_state.client_count; i++) {
-        if (reavix_state.clients[i].stream == stream) {
-            return &reavix_state.clients[i];
-        }
-    }
-    return NULL;
+    // The context is stored on the handle at accept time
+    return stream ? stream->data : NULL;
 }
 
 
-static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler) {
+static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler,
+                        uint8_t handler_mode) {
     if (!root || !path) return false;
 
     char* path_copy = strdup(path);
@@ -497,7 +4607,6 @@ static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler)
 
     while (segment) {
         bool is_param = (segment[0] == ':');
-        TrieNode** target = is_param ? &current->param_child : NULL;
         bool found = false;
 
         if (!is_param) {
@@ -508,6 +4617,9 @@ static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler)
                     break;
                 }
             }
+        } else if (current->param_child) {
+            current = current->param_child;
+            found = true;
         }
 
         if (!found) {
@@ -519,6 +4631,7 @@ static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler)
 
             if (is_param) {
                 current->param_child = new_node;
+                current = current->param_child;
             } else {
                 current->child_count++;
                 current->children = realloc(current->children, current->child_count * sizeof(TrieNode));
@@ -529,100 +4642,105 @@ static bool trie_insert(TrieNode* root, const char* path, RouteHandler handler)
                 }
                 current->children[current->child_count - 1] = *new_node;
                 free(new_node);
+                current = &current->children[current->child_count - 1];
             }
-            current = is_param ? current->param_child : &current->children[current->child_count - 1];
         }
 
         segment = strtok_r(NULL, "/", &saveptr);
     }
 
     current->handler = handler;
+    current->handler_mode = handler_mode;
     free(path_copy);
     return true;
 }
 
-static bool trie_match(TrieNode* root, const char* path, PathParam params[], 
-                      size_t* param_count, RouteHandler* out_handler) {
+// Zero-allocation matcher: walks the path with length-delimited views
+// instead of strdup/strtok_r, and captures parameter values as
+// (pointer, length) pairs into the caller's path buffer. No heap
+// traffic on the hot path.
+static bool trie_match(TrieNode* root, const char* path, PathParam params[],
+                      size_t* param_count, RouteHandler* out_handler,
+                      uint8_t* out_mode) {
     if (!root || !path || !param_count || !out_handler) return false;
 
-    char* path_copy = strdup(path);
-    if (!path_copy) return false;
-
-    char* saveptr;
-    char* segment = strtok_r(path_copy, "/", &saveptr);
+    const char* p = path;
     TrieNode* current = root;
 
     size_t param_index = 0;
-    while (segment) {
-        bool is_param = (segment[0] == ':');
-        TrieNode** target = is_param ? &current->param_child : NULL;
-        bool found = false;
+    while (*p) {
+        while (*p == '/') p++;
+        if (!*p) break;
 
-        if (!is_param) {
-            for (size_t i = 0; i < current->child_count; i++) {
-                if (strcmp(current->children[i].segment, segment) == 0) {
-                    current = &current->children[i];
-                    found = true;
-                    break;
-                }
+        const char* segment = p;
+        while (*p && *p != '/') p++;
+        size_t segment_len = (size_t)(p - segment);
+
+        bool found = false;
+        for (size_t i = 0; i < current->child_count; i++) {
+            const char* child_segment = current->children[i].segment;
+            if (strncmp(child_segment, segment, segment_len) == 0 &&
+                child_segment[segment_len] == '\0') {
+                current = &current->children[i];
+                found = true;
+                break;
             }
         }
 
         if (!found) {
-            if (is_param && current->param_child && param_index < MAX_PARAMS) {
+            if (current->param_child && param_index < MAX_PARAMS) {
                 params[param_index].name = current->param_child->segment + 1;
-                params[param_index].value = strdup(segment);
+                params[param_index].value = segment;
+                params[param_index].value_len = segment_len;
                 param_index++;
                 current = current->param_child;
             } else {
-                free(path_copy);
                 return false;
             }
         }
-
-        segment = strtok_r(NULL, "/", &saveptr);
     }
 
-    free(path_copy);
     *param_count = param_index;
     *out_handler = current->handler;
+    if (out_mode) *out_mode = current->handler_mode;
     return current->handler != NULL;
 }
 
-// Memory management
+// Memory management. Arena-owned requests/responses are reclaimed in
+// bulk by the connection's arena_reset(); these only tear down objects
+// built on the heap outside a connection lifecycle.
 void request_free(Request* req) {
     if (!req) return;
-    
+    if (req->_internal.arena) return;
+
     for (size_t i = 0; i < req->_internal.header_count; i++) {
         free((void*)req->_internal.header_names[i]);
         free((void*)req->_internal.header_values[i]);
     }
-    
+
     free(req->_internal.header_names);
     free(req->_internal.header_values);
-    
-    for (size_t i = 0; i < req->_internal.param_count; i++) {
-        free((void*)req->_internal.param_names[i]);
-        free((void*)req->_internal.param_values[i]);
-    }
-    
-    free(req->_internal.param_names);
-    free(req->_internal.param_values);
+
+    // Params are borrowed views into req->path; nothing to free
+    free((void*)req->method);
+    free((void*)req->path);
+    free((void*)req->query);
     free((void*)req->body);
     free(req);
 }
 
 void response_free(Response* res) {
     if (!res) return;
-    
+    if (res->_internal.arena) return;
+
     free(res->content);
-    
+
     for (size_t i = 0; i < res->_internal.header_count; i++) {
         free(res->_internal.header_names[i]);
         free(res->_internal.header_values[i]);
     }
-    
+
     free(res->_internal.header_names);
     free(res->_internal.header_values);
     free(res);
-}
\ No newline at end of file
+}
@@ -1,35 +1,45 @@
-#include "libreavix.h";
-#include "router.h";
-#include <uv.h>
+#include "libreavix.h"
+#include <stdio.h>
 
-uv_loop_t* loop;
-TrieNode route_tree;
+static void handle_get_users(const Request* req, Response* res) {
+    (void)req;
+    res_send_json(res, "{\"users\":[]}");
+}
 
+static bool upload_on_chunk(const Request* req, Response* res,
+                            const char* chunk, size_t len, void* user) {
+    (void)req; (void)res; (void)chunk; (void)len; (void)user;
+    // A real handler would append the chunk to disk here
+    return true;
+}
 
+static void upload_on_done(const Request* req, Response* res, void* user) {
+    (void)user;
+    reavix_log(LOG_INFO, NULL, "Received upload of %zu bytes", req_get_body_length(req));
+    res_send_json(res, "{\"status\":\"ok\"}");
+}
 
-int main(){
+static void handle_upload(const Request* req, Response* res) {
+    req_stream_body(req, res, upload_on_chunk, upload_on_done, NULL);
+}
+
+int main(void) {
 
     //Initialize libreavix
-    if(!reavix_init(100)){
-        REAVIX_LOG(LOG_FATAL,NULL,"Router initialization failed");
+    if (!reavix_init(100)) {
+        reavix_log(LOG_FATAL, NULL, "Router initialization failed");
         return 1;
     }
 
     //Register routes
-    reavix_route("GET","/api/users",handle_get_users);
-    reavix_route("POST","/api/upload",handle_upload);
-
-    //start libuv event loop
-    loop = uv_default_loop();
-    uv_tcp_t server;
-    uv_tcp_init(loop, &server);
+    reavix_route("GET", "/api/users", handle_get_users);
+    reavix_route_stream("POST", "/api/upload", handle_upload);
 
-    struct sockaddr_in addr;
-    uv_ip4_addr("0.0.0.0", 8081, &addr);
-    uv_tcp_bind(&server, (const struct sockaddr*)&addr, 0);
+    //Compile the route table for cache-friendly dispatch
+    reavix_router_seal();
 
-    uv_listen((uv_stream_t*)&server, 128, on_new_connection);
-    REAVIX_LOG(LOG_INFO,NULL,"Server running on port 8081");
+    //Run one worker loop per core (blocks until shutdown)
+    reavix_server_threaded(8081, 4);
 
-    return uv_run(loop, UV_RUN_DEFAULT);
-}
\ No newline at end of file
+    return 0;
+}
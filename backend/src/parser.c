@@ -0,0 +1,158 @@
+#include "parser.h"
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define PARSER_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define PARSER_NEON 1
+#endif
+
+// All SIMD variants implement the same primitive: index of the first
+// '\r' at or after start, or len if none. Boundary logic on top of it
+// is shared and scalar.
+
+static size_t find_cr_scalar(const char* data, size_t len, size_t start) {
+    for (size_t i = start; i < len; i++) {
+        if (data[i] == '\r') return i;
+    }
+    return len;
+}
+
+#ifdef PARSER_X86
+
+__attribute__((target("avx2")))
+static size_t find_cr_avx2(const char* data, size_t len, size_t start) {
+    size_t i = start;
+    const __m256i cr = _mm256_set1_epi8('\r');
+    for (; i + 32 <= len; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + i));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr));
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    return find_cr_scalar(data, len, i);
+}
+
+static size_t find_cr_sse2(const char* data, size_t len, size_t start) {
+    size_t i = start;
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, cr));
+        if (mask) return i + (size_t)__builtin_ctz(mask);
+    }
+    return find_cr_scalar(data, len, i);
+}
+
+#endif // PARSER_X86
+
+#ifdef PARSER_NEON
+
+static size_t find_cr_neon(const char* data, size_t len, size_t start) {
+    size_t i = start;
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t chunk = vld1q_u8((const uint8_t*)(data + i));
+        uint8x16_t eq = vceqq_u8(chunk, cr);
+        // Narrow each 16-bit lane pair to 4 bits so the comparison mask
+        // fits a 64-bit scalar (the usual NEON movemask substitute)
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask) return i + ((size_t)__builtin_ctzll(mask) >> 2);
+    }
+    return find_cr_scalar(data, len, i);
+}
+
+#endif // PARSER_NEON
+
+typedef size_t (*find_cr_fn)(const char* data, size_t len, size_t start);
+
+static find_cr_fn find_cr;
+
+static find_cr_fn select_find_cr(void) {
+#if defined(PARSER_X86)
+    if (__builtin_cpu_supports("avx2")) return find_cr_avx2;
+    return find_cr_sse2;  // SSE2 is the x86-64 baseline
+#elif defined(PARSER_NEON)
+    return find_cr_neon;
+#else
+    return find_cr_scalar;
+#endif
+}
+
+void parser_init(void) {
+    find_cr = select_find_cr();
+}
+
+size_t parser_find_headers_end(const char* data, size_t len) {
+    if (!find_cr) parser_init();
+
+    size_t i = 0;
+    while (i + 3 < len) {
+        i = find_cr(data, len, i);
+        if (i + 3 >= len) return 0;
+        if (data[i + 1] == '\n' && data[i + 2] == '\r' && data[i + 3] == '\n') {
+            return i + 4;
+        }
+        i++;
+    }
+    return 0;
+}
+
+ssize_t parser_parse_request(const char* data, size_t len, ParsedRequest* out) {
+    if (!data || !out) return -1;
+    if (!find_cr) parser_init();
+
+    memset(out, 0, sizeof(*out));
+    out->minor_version = -1;
+
+    size_t end = parser_find_headers_end(data, len);
+    if (end == 0) return 0;
+
+    // Request line: METHOD SP target SP HTTP/1.x CRLF
+    size_t line_end = find_cr(data, end, 0);
+    const char* sp1 = memchr(data, ' ', line_end);
+    if (!sp1) return -1;
+    out->method = data;
+    out->method_len = (size_t)(sp1 - data);
+
+    const char* target = sp1 + 1;
+    const char* sp2 = memchr(target, ' ', (size_t)(data + line_end - target));
+    if (!sp2) return -1;
+    out->target = target;
+    out->target_len = (size_t)(sp2 - target);
+
+    const char* version = sp2 + 1;
+    size_t version_len = (size_t)(data + line_end - version);
+    if (version_len == 8 && memcmp(version, "HTTP/1.", 7) == 0) {
+        if (version[7] == '0') out->minor_version = 0;
+        else if (version[7] == '1') out->minor_version = 1;
+    }
+
+    // Header lines, one CRLF-delimited (name, value) view pair each
+    size_t pos = line_end + 2;
+    while (pos + 2 <= end - 2) {
+        size_t eol = find_cr(data, end, pos);
+        if (eol <= pos) break;
+
+        const char* colon = memchr(data + pos, ':', eol - pos);
+        if (!colon) return -1;
+
+        const char* value = colon + 1;
+        while (value < data + eol && (*value == ' ' || *value == '\t')) value++;
+
+        if (out->header_count < PARSER_MAX_HEADERS) {
+            HeaderView* h = &out->headers[out->header_count++];
+            h->name = data + pos;
+            h->name_len = (size_t)(colon - (data + pos));
+            h->value = value;
+            h->value_len = (size_t)(data + eol - value);
+        }
+
+        pos = eol + 2;
+    }
+
+    return (ssize_t)end;
+}
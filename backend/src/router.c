@@ -1,121 +1,313 @@
 #include "router.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 #include <pthread.h>
 
 static Router router = {0};
 
+static RouterNode* create_router_node(const char* segment);
+static RouterNode* clone_router_node(const RouterNode* node);
+
+// Node slab. Every router allocation — build-tree nodes, child arrays,
+// segment strings, route-table strings, published snapshots — comes
+// from one bump-pointer block chain, so loading n routes costs pointer
+// bumps instead of per-segment mallocs, and teardown is a handful of
+// block frees instead of a recursive walk. Superseded allocations
+// (grown child arrays, folded segments, retired snapshots) are simply
+// abandoned in their block; routes are immutable after startup, so the
+// waste is bounded by the registration phase, exactly as the old
+// retired-snapshot list was.
+#define ROUTER_SLAB_BLOCK (64 * 1024)
+
+struct RouterSlabBlock {
+    struct RouterSlabBlock* next;
+    size_t used;
+    size_t capacity;
+    char data[];
+};
+
+static void* slab_alloc(size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    RouterSlabBlock* block = router.slab;
+    if (!block || block->capacity - block->used < size) {
+        size_t cap = size > ROUTER_SLAB_BLOCK ? size : ROUTER_SLAB_BLOCK;
+        block = malloc(sizeof(RouterSlabBlock) + cap);
+        if (!block) return NULL;
+        block->next = router.slab;
+        block->used = 0;
+        block->capacity = cap;
+        router.slab = block;
+    }
+    void* p = block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+static char* slab_strdup(const char* s) {
+    size_t len = strlen(s) + 1;
+    char* copy = slab_alloc(len);
+    if (copy) memcpy(copy, s, len);
+    return copy;
+}
+
+// Map a method string onto the compact enum, or -1 if it is not one of
+// the dispatchable methods. First-letter switch keeps this to at most
+// one strcmp per call.
+static int method_index(const char* method) {
+    switch (method[0]) {
+        case 'G': return strcmp(method, "GET") == 0 ? ROUTE_METHOD_GET : -1;
+        case 'P':
+            if (strcmp(method, "POST") == 0) return ROUTE_METHOD_POST;
+            if (strcmp(method, "PUT") == 0) return ROUTE_METHOD_PUT;
+            if (strcmp(method, "PATCH") == 0) return ROUTE_METHOD_PATCH;
+            return -1;
+        case 'D': return strcmp(method, "DELETE") == 0 ? ROUTE_METHOD_DELETE : -1;
+        case 'H': return strcmp(method, "HEAD") == 0 ? ROUTE_METHOD_HEAD : -1;
+        case 'O': return strcmp(method, "OPTIONS") == 0 ? ROUTE_METHOD_OPTIONS : -1;
+        default: return -1;
+    }
+}
+
+static bool node_has_handler(const RouterNode* node) {
+    for (size_t i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (node->handlers[i]) return true;
+    }
+    return false;
+}
+
+// Duplicate-registration check: an open-addressed hash set over
+// (method, path), storing route-table indices offset by one so zero
+// means empty. Replaces the former linear scan of every registered
+// route, which alone made loading n routes O(n^2).
+static uint32_t route_hash(const char* method, const char* path) {
+    uint32_t h = 2166136261u;
+    for (const char* p = method; *p; p++) { h = (h ^ (uint8_t)*p) * 16777619u; }
+    h = (h ^ (uint8_t)' ') * 16777619u;
+    for (const char* p = path; *p; p++) { h = (h ^ (uint8_t)*p) * 16777619u; }
+    return h;
+}
+
+static bool dup_contains(const char* method, const char* path) {
+    size_t mask = router.dup_capacity - 1;
+    for (size_t i = route_hash(method, path) & mask; ; i = (i + 1) & mask) {
+        uint32_t slot = router.dup_table[i];
+        if (slot == 0) return false;
+        RouteEntry* entry = &router.routes[slot - 1];
+        if (strcmp(entry->method, method) == 0 && strcmp(entry->path, path) == 0) {
+            return true;
+        }
+    }
+}
+
+static void dup_place(uint32_t* table, size_t capacity, uint32_t slot,
+                      const char* method, const char* path) {
+    size_t mask = capacity - 1;
+    size_t i = route_hash(method, path) & mask;
+    while (table[i] != 0) i = (i + 1) & mask;
+    table[i] = slot;
+}
+
+// Keeps the load factor under 3/4; capacity stays a power of two
+static bool dup_reserve(void) {
+    if ((router.route_count + 1) * 4 < router.dup_capacity * 3) return true;
+
+    size_t new_capacity = router.dup_capacity * 2;
+    uint32_t* table = calloc(new_capacity, sizeof(uint32_t));
+    if (!table) return false;
+    for (size_t i = 0; i < router.route_count; i++) {
+        dup_place(table, new_capacity, (uint32_t)(i + 1),
+                  router.routes[i].method, router.routes[i].path);
+    }
+    free(router.dup_table);
+    router.dup_table = table;
+    router.dup_capacity = new_capacity;
+    return true;
+}
+
 bool router_init(size_t initial_capacity) {
     if (router.root != NULL) {
         return false;
     }
 
-    router.root = calloc(1, sizeof(TrieNode));
-    if (!router.root) {
+    router.dup_capacity = 64;
+    while (router.dup_capacity < initial_capacity * 2) router.dup_capacity *= 2;
+    router.dup_table = calloc(router.dup_capacity, sizeof(uint32_t));
+    if (!router.dup_table) {
         return false;
     }
 
     router.routes = malloc(initial_capacity * sizeof(RouteEntry));
     if (!router.routes) {
-        free(router.root);
+        free(router.dup_table);
+        router.dup_table = NULL;
+        return false;
+    }
+
+    router.root = slab_alloc(sizeof(RouterNode));
+    if (!router.root) {
+        free(router.dup_table);
+        router.dup_table = NULL;
+        free(router.routes);
+        router.routes = NULL;
         return false;
     }
+    memset(router.root, 0, sizeof(RouterNode));
 
     router.route_capacity = initial_capacity;
     router.route_count = 0;
+    atomic_store(&router.live_root, NULL);
     pthread_mutex_init(&router.mutex, NULL);
     return true;
 }
 
 void router_free() {
     pthread_mutex_lock(&router.mutex);
-    
-    // Free trie nodes recursively
-    free_trie_node(router.root);
-    
-    // Free route entries
-    for (size_t i = 0; i < router.route_count; i++) {
-        free(router.routes[i].method);
-        free(router.routes[i].path);
+
+    // Both trees, every node, string and child array live in the slab
+    RouterSlabBlock* block = router.slab;
+    while (block) {
+        RouterSlabBlock* next = block->next;
+        free(block);
+        block = next;
     }
+
     free(router.routes);
-    
+    free(router.dup_table);
+
     pthread_mutex_unlock(&router.mutex);
     pthread_mutex_destroy(&router.mutex);
     memset(&router, 0, sizeof(Router));
 }
 
-static void free_trie_node(TrieNode* node) {
-    if (!node) return;
-    
-    free(node->segment);
-    
-    for (size_t i = 0; i < node->child_count; i++) {
-        free_trie_node(&node->children[i]);
-    }
-    
-    free(node->children);
-    free_trie_node(node->param_child);
-    free(node);
-}
-
-static TrieNode* create_trie_node(const char* segment) {
-    TrieNode* node = calloc(1, sizeof(TrieNode));
+static RouterNode* create_router_node(const char* segment) {
+    RouterNode* node = slab_alloc(sizeof(RouterNode));
     if (!node) return NULL;
+    memset(node, 0, sizeof(RouterNode));
 
-    node->segment = strdup(segment);
-    if (!node->segment) {
-        free(node);
-        return NULL;
-    }
+    node->segment = slab_strdup(segment);
+    if (!node->segment) return NULL;
     return node;
 }
 
-bool router_add(const char* method, const char* path, RouteHandler handler) {
-    if (!method || !path || !handler) return false;
+// Deep-copy a trie subtree. Snapshots published to readers are built
+// with this so the build tree can keep mutating under the mutex. On
+// failure the partial copy is abandoned in the slab.
+static bool clone_router_into(const RouterNode* src, RouterNode* dst) {
+    dst->segment = src->segment ? slab_strdup(src->segment) : NULL;
+    memcpy(dst->handlers, src->handlers, sizeof(dst->handlers));
+    dst->rate_limit = src->rate_limit;
+    dst->child_count = src->child_count;
+    dst->child_capacity = src->child_count;
+    dst->children = NULL;
+    dst->param_child = NULL;
+
+    if (src->child_count > 0) {
+        dst->children = slab_alloc(src->child_count * sizeof(RouterNode));
+        if (!dst->children) return false;
+        memset(dst->children, 0, src->child_count * sizeof(RouterNode));
+        for (size_t i = 0; i < src->child_count; i++) {
+            if (!clone_router_into(&src->children[i], &dst->children[i])) return false;
+        }
+    }
 
-    pthread_mutex_lock(&router.mutex);
+    if (src->param_child) {
+        dst->param_child = clone_router_node(src->param_child);
+        if (!dst->param_child) return false;
+    }
+    return true;
+}
 
-    // Check if route already exists
-    for (size_t i = 0; i < router.route_count; i++) {
-        if (strcmp(router.routes[i].method, method) == 0 &&
-            strcmp(router.routes[i].path, path) == 0) {
-            pthread_mutex_unlock(&router.mutex);
-            return false;
+static RouterNode* clone_router_node(const RouterNode* node) {
+    RouterNode* copy = slab_alloc(sizeof(RouterNode));
+    if (!copy) return NULL;
+    memset(copy, 0, sizeof(RouterNode));
+    if (!clone_router_into(node, copy)) {
+        return NULL;
+    }
+    return copy;
+}
+
+// Radix compression, run on a fresh snapshot before it is published: a
+// pass-through node (no handlers, exactly one static child, no param
+// child) absorbs that child, joining the labels with '/'. Repeated, a
+// chain like api -> v2 -> internal collapses into one "api/v2/internal"
+// label costing a single comparison. The root and param nodes are never
+// folded — the root is the anonymous entry point, and a param node's
+// label must stay a single segment for value capture.
+static void compress_subtree(RouterNode* node, bool is_root) {
+    if (!is_root && node->segment[0] != ':') {
+        while (node->child_count == 1 && !node->param_child &&
+               !node_has_handler(node)) {
+            RouterNode* child = &node->children[0];
+
+            size_t need = strlen(node->segment) + 1 + strlen(child->segment) + 1;
+            char* joined = slab_alloc(need);
+            if (!joined) break;
+            snprintf(joined, need, "%s/%s", node->segment, child->segment);
+
+            // The folded node's old segment and one-element child array
+            // are abandoned in the slab
+            node->segment = joined;
+            memcpy(node->handlers, child->handlers, sizeof(node->handlers));
+            node->rate_limit = child->rate_limit;
+            node->param_child = child->param_child;
+
+            RouterNode* grandchildren = child->children;
+            size_t grandchild_count = child->child_count;
+            node->children = grandchildren;
+            node->child_count = grandchild_count;
+            node->child_capacity = grandchild_count;
         }
     }
 
-    // Add to route table
+    for (size_t i = 0; i < node->child_count; i++) {
+        compress_subtree(&node->children[i], false);
+    }
+    if (node->param_child) {
+        compress_subtree(node->param_child, false);
+    }
+}
+
+// Publish a fresh snapshot of the build tree. Caller holds router.mutex.
+// The previous snapshot may still be in use by in-flight readers, so it
+// is abandoned in place; its slab blocks are reclaimed in router_free().
+static bool router_publish(void) {
+    RouterNode* snapshot = clone_router_node(router.root);
+    if (!snapshot) return false;
+    compress_subtree(snapshot, true);
+
+    atomic_store_explicit(&router.live_root, snapshot, memory_order_release);
+    return true;
+}
+
+// Caller holds router.mutex. Appends one route to the table and threads
+// its path into the build tree without publishing, so batch loads pay
+// for one snapshot instead of one per route.
+static bool route_insert_locked(const char* method, const char* path,
+                                RouteHandler handler, int m) {
+    if (dup_contains(method, path)) return false;
+    if (!dup_reserve()) return false;
+
     if (router.route_count >= router.route_capacity) {
         size_t new_capacity = router.route_capacity * 2;
         RouteEntry* new_routes = realloc(router.routes, new_capacity * sizeof(RouteEntry));
-        if (!new_routes) {
-            pthread_mutex_unlock(&router.mutex);
-            return false;
-        }
+        if (!new_routes) return false;
         router.routes = new_routes;
         router.route_capacity = new_capacity;
     }
 
-    router.routes[router.route_count].method = strdup(method);
-    router.routes[router.route_count].path = strdup(path);
-    router.routes[router.route_count].handler = handler;
-    router.route_count++;
-
-    // Add to trie
-    char* path_copy = strdup(path);
-    if (!path_copy) {
-        pthread_mutex_unlock(&router.mutex);
-        return false;
-    }
+    char* method_copy = slab_strdup(method);
+    char* path_entry = slab_strdup(path);
+    char* path_copy = slab_strdup(path);  // strtok_r scratch, abandoned after
+    if (!method_copy || !path_entry || !path_copy) return false;
 
     char* saveptr;
     char* segment = strtok_r(path_copy, "/", &saveptr);
-    TrieNode* current = router.root;
+    RouterNode* current = router.root;
 
     while (segment) {
         bool is_param = (segment[0] == ':');
-        TrieNode** target = is_param ? &current->param_child : NULL;
         bool found = false;
 
         if (!is_param) {
@@ -126,70 +318,154 @@ bool router_add(const char* method, const char* path, RouteHandler handler) {
                     break;
                 }
             }
+        } else if (current->param_child) {
+            current = current->param_child;
+            found = true;
         }
 
         if (!found) {
-            TrieNode* new_node = create_trie_node(segment);
-            if (!new_node) {
-                free(path_copy);
-                pthread_mutex_unlock(&router.mutex);
-                return false;
-            }
+            RouterNode* new_node = create_router_node(segment);
+            if (!new_node) return false;
 
             if (is_param) {
                 current->param_child = new_node;
                 current = new_node;
             } else {
-                TrieNode* new_children = realloc(current->children, 
-                    (current->child_count + 1) * sizeof(TrieNode));
-                if (!new_children) {
-                    free(new_node->segment);
-                    free(new_node);
-                    free(path_copy);
-                    pthread_mutex_unlock(&router.mutex);
-                    return false;
+                // Geometric growth keeps abandoned-array waste linear
+                // in the child count instead of quadratic
+                if (current->child_count == current->child_capacity) {
+                    size_t new_cap = current->child_capacity ? current->child_capacity * 2 : 4;
+                    RouterNode* grown = slab_alloc(new_cap * sizeof(RouterNode));
+                    if (!grown) return false;
+                    memcpy(grown, current->children,
+                           current->child_count * sizeof(RouterNode));
+                    current->children = grown;
+                    current->child_capacity = new_cap;
                 }
-                current->children = new_children;
+                // Bump the parent's count before descending — the old
+                // code incremented the freshly placed child's count
+                // instead, leaving every new node invisible to lookups
                 current->children[current->child_count] = *new_node;
-                free(new_node);
-                current = &current->children[current->child_count];
+                RouterNode* placed = &current->children[current->child_count];
                 current->child_count++;
+                current = placed;
             }
         }
 
         segment = strtok_r(NULL, "/", &saveptr);
     }
 
-    current->handler = handler;
-    free(path_copy);
+    current->handlers[m] = handler;
+
+    router.routes[router.route_count].method = method_copy;
+    router.routes[router.route_count].path = path_entry;
+    router.routes[router.route_count].handler = handler;
+    router.route_count++;
+    dup_place(router.dup_table, router.dup_capacity,
+              (uint32_t)router.route_count, method_copy, path_entry);
+    return true;
+}
+
+bool router_add(const char* method, const char* path, RouteHandler handler) {
+    if (!method || !path || !handler) return false;
+
+    int m = method_index(method);
+    if (m < 0) return false;
+
+    pthread_mutex_lock(&router.mutex);
+    bool inserted = route_insert_locked(method, path, handler, m);
+    bool published = inserted && router_publish();
     pthread_mutex_unlock(&router.mutex);
+    return published;
+}
+
+size_t router_add_batch(const RouteSpec* entries, size_t n) {
+    if (!entries || n == 0) return 0;
+
+    pthread_mutex_lock(&router.mutex);
+
+    size_t added = 0;
+    for (size_t i = 0; i < n; i++) {
+        const RouteSpec* spec = &entries[i];
+        if (!spec->method || !spec->path || !spec->handler) continue;
+        int m = method_index(spec->method);
+        if (m < 0) continue;
+        if (route_insert_locked(spec->method, spec->path, spec->handler, m)) {
+            added++;
+        }
+    }
+
+    // One snapshot for the whole batch — cloning the tree per insert is
+    // what made incremental loading quadratic
+    if (added > 0 && !router_publish()) {
+        added = 0;
+    }
+
+    pthread_mutex_unlock(&router.mutex);
+    return added;
+}
+
+// Try to consume a (possibly multi-segment) radix label from the path
+// at *pp, comparing segment by segment so repeated slashes in the path
+// are tolerated. On a full match *pp advances past the consumed bytes.
+static bool match_label(const char* label, const char** pp) {
+    const char* p = *pp;
+    const char* l = label;
+
+    while (*l) {
+        while (*p == '/') p++;
+        const char* seg = p;
+        while (*p && *p != '/') p++;
+        size_t seg_len = (size_t)(p - seg);
+        if (seg_len == 0) return false;  // path ended before the label did
+
+        const char* lseg = l;
+        while (*l && *l != '/') l++;
+        size_t lseg_len = (size_t)(l - lseg);
+        if (*l == '/') l++;
+
+        if (seg_len != lseg_len || memcmp(seg, lseg, seg_len) != 0) {
+            return false;
+        }
+    }
+
+    *pp = p;
     return true;
 }
 
-bool router_match(const char* method, const char* path, 
+bool router_match(const char* method, const char* path,
                  PathParam* params, size_t* param_count,
                  RouteHandler* handler) {
     if (!path || !handler) return false;
 
-    pthread_mutex_lock(&router.mutex);
-
-    char* path_copy = strdup(path);
-    if (!path_copy) {
-        pthread_mutex_unlock(&router.mutex);
-        return false;
+    int m = -1;
+    if (method) {
+        m = method_index(method);
+        if (m < 0) return false;
     }
 
-    char* saveptr;
-    char* segment = strtok_r(path_copy, "/", &saveptr);
-    TrieNode* current = router.root;
+    // Lock-free read path: walk the published immutable snapshot. The
+    // route table itself is append-only and frozen after startup.
+    RouterNode* root = atomic_load_explicit(&router.live_root, memory_order_acquire);
+    if (!root) return false;
+
+    // Zero-allocation walk: length-delimited views into the caller's
+    // path, parameter values captured as (pointer, length) pairs.
+    const char* p = path;
+    RouterNode* current = root;
     *param_count = 0;
 
-    while (segment) {
+    while (*p) {
+        while (*p == '/') p++;
+        if (!*p) break;
+
         bool found = false;
 
-        // Check static children first
+        // Check static children first; labels may span several segments
         for (size_t i = 0; i < current->child_count; i++) {
-            if (strcmp(current->children[i].segment, segment) == 0) {
+            const char* q = p;
+            if (match_label(current->children[i].segment, &q)) {
+                p = q;
                 current = &current->children[i];
                 found = true;
                 break;
@@ -198,9 +474,12 @@ bool router_match(const char* method, const char* path,
 
         // Check parameter child
         if (!found && current->param_child) {
+            const char* segment = p;
+            while (*p && *p != '/') p++;
             if (params && *param_count < MAX_PARAMS) {
                 params[*param_count].name = current->param_child->segment + 1;
-                params[*param_count].value = strdup(segment);
+                params[*param_count].value = segment;
+                params[*param_count].value_len = (size_t)(p - segment);
                 (*param_count)++;
             }
             current = current->param_child;
@@ -208,28 +487,22 @@ bool router_match(const char* method, const char* path,
         }
 
         if (!found) {
-            free(path_copy);
-            pthread_mutex_unlock(&router.mutex);
             return false;
         }
+    }
 
-        segment = strtok_r(NULL, "/", &saveptr);
+    // Per-method dispatch straight off the node: no handler-pointer
+    // scan of the route table, and methods never alias each other
+    if (m >= 0) {
+        *handler = current->handlers[m];
+        return *handler != NULL;
     }
 
-    *handler = current->handler;
-    free(path_copy);
-    pthread_mutex_unlock(&router.mutex);
-    
-    // Verify method matches
-    if (method) {
-        for (size_t i = 0; i < router.route_count; i++) {
-            if (router.routes[i].handler == *handler && 
-                strcmp(router.routes[i].method, method) == 0) {
-                return true;
-            }
+    for (size_t i = 0; i < ROUTE_METHOD_COUNT; i++) {
+        if (current->handlers[i]) {
+            *handler = current->handlers[i];
+            return true;
         }
-        return false;
     }
-    
-    return true;
-}
\ No newline at end of file
+    return false;
+}
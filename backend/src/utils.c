@@ -1 +1,82 @@
-//Utils
\ No newline at end of file
+//Utils
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+
+void arena_init(Arena* arena, size_t block_size) {
+    arena->head = NULL;
+    arena->block_size = block_size ? block_size : 4096;
+}
+
+static ArenaBlock* arena_block_new(size_t size) {
+    ArenaBlock* block = malloc(sizeof(ArenaBlock) + size);
+    if (!block) return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena || size == 0) return NULL;
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    ArenaBlock* block = arena->head;
+    if (!block || block->used + size > block->size) {
+        size_t block_size = size > arena->block_size ? size : arena->block_size;
+        ArenaBlock* fresh = arena_block_new(block_size);
+        if (!fresh) return NULL;
+        fresh->next = arena->head;
+        arena->head = fresh;
+        block = fresh;
+    }
+
+    void* ptr = block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+char* arena_strdup(Arena* arena, const char* s) {
+    if (!s) return NULL;
+    return arena_strndup(arena, s, strlen(s));
+}
+
+char* arena_strndup(Arena* arena, const char* s, size_t n) {
+    if (!s) return NULL;
+    char* copy = arena_alloc(arena, n + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, n);
+    copy[n] = '\0';
+    return copy;
+}
+
+// Drop all blocks except the newest (typically the largest and hottest)
+// and rewind it, so steady-state requests reuse one warm block with no
+// heap traffic at all.
+void arena_reset(Arena* arena) {
+    if (!arena || !arena->head) return;
+
+    ArenaBlock* block = arena->head->next;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head->next = NULL;
+    arena->head->used = 0;
+}
+
+void arena_destroy(Arena* arena) {
+    if (!arena) return;
+
+    ArenaBlock* block = arena->head;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+}